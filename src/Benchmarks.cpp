@@ -0,0 +1,122 @@
+#include "Benchmarks.h"
+#include "clRowEntry.h"
+#include "clTreeCtrl.h"
+#include <vector>
+#include <wx/crt.h>
+#include <wx/stopwatch.h>
+
+namespace
+{
+const size_t kRowsCount = 1000000;
+const int kPassesCount = 10;
+
+void Report(const wxString& message) { wxPrintf("%s\n", message); }
+
+/**
+ * @brief walk a tree of 1M rows, the way GetExpandedLines, UnselectAll or clTreeNodeVisitor do. The rows are appended
+ * to 1000 parents in turns, so siblings are not allocated next to each other
+ */
+void BenchmarkTraversal(wxWindow* parent)
+{
+    const size_t parentsCount = 1000;
+    clTreeCtrl* tree = new clTreeCtrl(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxTR_HIDE_ROOT);
+    tree->Hide();
+    tree->SetSortFunction(nullptr);
+    tree->GetModel().EnableMemoryPool(true);
+    wxTreeItemId root = tree->AddRoot("Root");
+    std::vector<wxTreeItemId> parents;
+    parents.reserve(parentsCount);
+    for(size_t i = 0; i < parentsCount; ++i) {
+        parents.push_back(tree->AppendItem(root, wxString() << "Folder " << i));
+    }
+    tree->Begin();
+    for(size_t i = 0; i < kRowsCount; ++i) {
+        tree->AppendItem(parents[(i * 7919) % parentsCount], "File");
+    }
+    tree->Commit();
+    // Expand every other folder: about half of the rows are visible
+    for(size_t i = 0; i < parentsCount; i += 2) {
+        tree->Expand(parents[i]);
+    }
+
+    // All the rows, following the list links
+    wxStopWatch sw;
+    size_t rowsCount = 0;
+    size_t checksum = 0;
+    for(int pass = 0; pass < kPassesCount; ++pass) {
+        for(clRowEntry* row = tree->GetModel().GetRoot(); row; row = row->GetNext()) {
+            ++rowsCount;
+            checksum += row->IsExpanded() + row->GetIndentsCount();
+        }
+    }
+    long fullWalk = sw.Time();
+
+    // The visible rows only
+    sw.Start();
+    clRowEntry::Vec_t items;
+    for(int pass = 0; pass < kPassesCount; ++pass) {
+        items.clear();
+        tree->GetModel().GetNextItems(tree->GetModel().GetRoot(), tree->GetRange(), items);
+    }
+    long visibleWalk = sw.Time();
+
+    Report(wxString() << "Traversal of " << (long)(rowsCount / kPassesCount) << " rows: all rows "
+                      << (fullWalk / kPassesCount) << "ms, " << (long)items.size() << " visible rows "
+                      << (visibleWalk / kPassesCount) << "ms (average of " << kPassesCount << " passes, checksum "
+                      << (long)checksum << ")");
+    delete tree;
+}
+
+/**
+ * @brief append 1M rows to a single parent, one by one with AppendItem and at once with AppendItems. Then sort them
+ * with SortChildren, which sorts using all the cores
+ */
+void BenchmarkAppend(wxWindow* parent)
+{
+    std::vector<clTreeItemInfo> items;
+    items.reserve(kRowsCount);
+    for(size_t i = 0; i < kRowsCount; ++i) {
+        items.emplace_back(wxString() << "Item " << (long)((i * 7919) % kRowsCount));
+    }
+
+    for(int method = 0; method < 3; ++method) {
+        clTreeCtrl* tree = new clTreeCtrl(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxTR_HIDE_ROOT);
+        tree->Hide();
+        tree->AddHeader("Name");
+        clSortFunc_t defaultSort = tree->GetModel().GetSortFunction();
+        if(method != 2) {
+            tree->SetSortFunction(nullptr);
+        }
+        wxTreeItemId root = tree->AddRoot("Root");
+        wxString name;
+        wxStopWatch sw;
+        if(method == 0) {
+            name = "AppendItem (unsorted)";
+            for(const clTreeItemInfo& item : items) {
+                tree->AppendItem(root, item.text);
+            }
+        } else {
+            name = (method == 1) ? "AppendItems (unsorted)" : "AppendItems (sorted)";
+            tree->AppendItems(root, items);
+        }
+        long appendTime = sw.Time();
+        Report(wxString() << name << " of " << (long)kRowsCount << " rows: " << appendTime << "ms");
+
+        if(method == 1) {
+            // Sort the rows appended unsorted, with the default (case insensitive) sort function
+            tree->SetSortFunction(defaultSort);
+            sw.Start();
+            tree->SortChildren(root);
+            Report(wxString() << "SortChildren of " << (long)kRowsCount << " rows: " << sw.Time() << "ms");
+        }
+        delete tree;
+    }
+}
+} // namespace
+
+void RunBenchmarks(wxWindow* parent)
+{
+    Report(wxString() << "Running the benchmarks (" << (long)kRowsCount << " rows)...");
+    BenchmarkTraversal(parent);
+    BenchmarkAppend(parent);
+}
@@ -0,0 +1,12 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+class wxWindow;
+
+/**
+ * @brief opt-in performance samples of the demo, run with: wxCustomControls --benchmark
+ * The controls are created (hidden) as children of 'parent' and the timings are printed to stdout
+ */
+void RunBenchmarks(wxWindow* parent);
+
+#endif // BENCHMARKS_H
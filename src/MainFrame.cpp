@@ -231,6 +231,7 @@ MainFrame::MainFrame(wxWindow* parent)
     m_choice->SetBitmap(images.Bitmap("folder_open"));
 
     m_treeCtrl->Bind(wxEVT_TREE_ITEM_EXPANDING, &MainFrame::OnItemExpanding, this);
+    m_treeCtrl->Bind(wxEVT_TREE_EXPANDING_ALL, &MainFrame::OnItemExpandingAll, this);
     m_treeCtrl->Bind(wxEVT_TREE_DELETE_ITEM, &MainFrame::OnItemDeleted, this);
     m_treeCtrl->Bind(wxEVT_TREE_BEGIN_DRAG, [&](wxTreeEvent& evt) {
         wxUnusedVar(evt);
@@ -496,7 +497,19 @@ void MainFrame::OnItemExpanding(wxTreeEvent& event)
     wxTreeItemId item = event.GetItem();
     wxString text = m_treeCtrl->GetItemText(item);
     LogMessage(wxString() << text << " is expanding");
+    DoLoadFolder(item);
+}
+
+void MainFrame::OnItemExpandingAll(wxTreeEvent& event)
+{
+    // ExpandAll does not fire wxEVT_TREE_ITEM_EXPANDING per item, load the whole subtree before it is expanded
+    event.Skip();
+    LogMessage(wxString() << m_treeCtrl->GetItemText(event.GetItem()) << " is expanding (all)");
+    DoLoadFolderTree(event.GetItem());
+}
 
+void MainFrame::DoLoadFolder(const wxTreeItemId& item)
+{
     wxTreeItemIdValue cookie;
     if(m_treeCtrl->ItemHasChildren(item)) {
         wxTreeItemId child = m_treeCtrl->GetFirstChild(item, cookie);
@@ -533,6 +546,19 @@ void MainFrame::OnItemExpanding(wxTreeEvent& event)
     }
 }
 
+void MainFrame::DoLoadFolderTree(const wxTreeItemId& item)
+{
+    DoLoadFolder(item);
+    wxTreeItemIdValue cookie;
+    wxTreeItemId child = m_treeCtrl->GetFirstChild(item, cookie);
+    while(child.IsOk()) {
+        if(m_treeCtrl->ItemHasChildren(child)) {
+            DoLoadFolderTree(child);
+        }
+        child = m_treeCtrl->GetNextChild(item, cookie);
+    }
+}
+
 void MainFrame::OnExpandAll(wxCommandEvent& event)
 {
     wxUnusedVar(event);
@@ -53,6 +53,14 @@ class MainFrame : public MainFrameBaseClass
 private:
     void LogMessage(const wxString& message);
     void DoAddRoot();
+    /**
+     * @brief replace the "dummy-node" child of a folder item with the folder content
+     */
+    void DoLoadFolder(const wxTreeItemId& item);
+    /**
+     * @brief load 'item' and all the folders below it
+     */
+    void DoLoadFolderTree(const wxTreeItemId& item);
 
 protected:
     virtual void OnShowMaximizeButton(wxCommandEvent& event);
@@ -95,6 +103,7 @@ protected:
     virtual void OnExpandAll(wxCommandEvent& event);
     virtual void OnOpenFolder(wxCommandEvent& event);
     void OnItemExpanding(wxTreeEvent& event);
+    void OnItemExpandingAll(wxTreeEvent& event);
     void OnItemDeleted(wxTreeEvent& event);
     void OnIncrementalSearch(wxTreeEvent& event);
     void OnResetSearch(wxTreeEvent& event);
@@ -0,0 +1,43 @@
+#include "clCellStyle.h"
+
+static wxString ColourKey(const wxColour& colour)
+{
+    if(!colour.IsOk()) {
+        return wxEmptyString;
+    }
+    return wxString() << (int)colour.Red() << "," << (int)colour.Green() << "," << (int)colour.Blue() << ","
+                      << (int)colour.Alpha();
+}
+
+std::wstring clCellStyle::GetKey() const
+{
+    wxString key;
+    key << (font.IsOk() ? font.GetNativeFontInfoDesc() : wxString()) << "|" << ColourKey(textColour) << "|"
+        << ColourKey(bgColour);
+    return key.ToStdWstring();
+}
+
+clCellStyleTable::clCellStyleTable()
+{
+    // Index 0 is always the default style
+    Intern(clCellStyle());
+}
+
+clCellStyleTable& clCellStyleTable::Get()
+{
+    static clCellStyleTable table;
+    return table;
+}
+
+uint32_t clCellStyleTable::Intern(const clCellStyle& style)
+{
+    std::wstring key = style.GetKey();
+    std::unordered_map<std::wstring, uint32_t>::iterator iter = m_indexes.find(key);
+    if(iter != m_indexes.end()) {
+        return iter->second;
+    }
+    uint32_t index = m_styles.size();
+    m_styles.push_back(style);
+    m_indexes.insert({ key, index });
+    return index;
+}
@@ -0,0 +1,50 @@
+#ifndef CLCELLSTYLE_H
+#define CLCELLSTYLE_H
+
+#include "codelite_exports.h"
+#include <deque>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <wx/colour.h>
+#include <wx/font.h>
+
+/**
+ * @brief the visual attributes of a cell. An invalid font or colour means "use the control's default"
+ */
+struct WXDLLIMPEXP_SDK clCellStyle {
+    wxFont font;
+    wxColour textColour;
+    wxColour bgColour;
+
+    /**
+     * @brief return a string that uniquely identifies this style
+     */
+    std::wstring GetKey() const;
+};
+
+/**
+ * @brief a global table of interned cell styles. Cells keep a small index into this table instead of a full
+ * copy of their style, and since most cells use the default style (index 0), cells with identical attributes
+ * share the same entry. Entries are never removed. Like the rest of the UI code, this table is not thread safe
+ */
+class WXDLLIMPEXP_SDK clCellStyleTable
+{
+    std::deque<clCellStyle> m_styles; // a deque, so references to the styles remain valid as the table grows
+    std::unordered_map<std::wstring, uint32_t> m_indexes;
+
+protected:
+    clCellStyleTable();
+
+public:
+    static clCellStyleTable& Get();
+
+    /**
+     * @brief return the index of 'style' in the table, adding it if needed
+     */
+    uint32_t Intern(const clCellStyle& style);
+    const clCellStyle& GetStyle(uint32_t index) const { return m_styles[index]; }
+    size_t GetCount() const { return m_styles.size(); }
+};
+
+#endif // CLCELLSTYLE_H
@@ -1,21 +1,26 @@
 #include "clCellValue.h"
 
-clCellValue::clCellValue() {}
+clCellValue::clCellValue()
+    : m_int64Value(0)
+{
+}
 
 clCellValue::clCellValue(const wxString& text, int bmpIndex, int bmpOpenIndex)
     : m_stringValue(text)
-    , m_type(kTypeString)
+    , m_int64Value(0)
     , m_bitmapIndex(bmpIndex)
     , m_bitmapSelectedIndex(bmpOpenIndex)
+    , m_type(kTypeString)
 {
 }
 
 clCellValue::clCellValue(bool bValue, const wxString& label, int bmpIndex, int bmpOpenIndex)
-    : m_boolValue(bValue)
-    , m_stringValue(label)
-    , m_type(kTypeBool)
+    : m_stringValue(label)
+    , m_int64Value(0)
     , m_bitmapIndex(bmpIndex)
     , m_bitmapSelectedIndex(bmpOpenIndex)
+    , m_type(kTypeBool)
+    , m_boolValue(bValue)
 {
 }
 
@@ -26,6 +31,109 @@ clCellValue::clCellValue(const char* ptext, int bmpIndex, int bmpOpenIndex)
 {
 }
 
-const wxString& clCellValue::GetValueString() const { return m_stringValue; }
+const wxString& clCellValue::GetValueString() const
+{
+    if(IsTyped() && !m_formatted) {
+        switch(m_type) {
+        case kTypeInt64:
+            m_stringValue.clear();
+            m_stringValue << m_int64Value;
+            break;
+        case kTypeDouble:
+            m_stringValue.clear();
+            m_stringValue << m_doubleValue;
+            break;
+        default:
+            m_stringValue = GetValueDateTime().FormatDate();
+            break;
+        }
+        m_formatted = true;
+    }
+    return m_stringValue;
+}
+
+void clCellValue::SetValue(const wxString& text)
+{
+    if(IsTyped()) {
+        m_type = kTypeString;
+    }
+    this->m_stringValue = text;
+}
+
+void clCellValue::DoSetTyped(eType type)
+{
+    m_type = type;
+    ClearFormatCache();
+}
+
+void clCellValue::SetValueInt64(wxLongLong_t value)
+{
+    DoSetTyped(kTypeInt64);
+    m_int64Value = value;
+}
+
+void clCellValue::SetValueDouble(double value)
+{
+    DoSetTyped(kTypeDouble);
+    m_doubleValue = value;
+}
+
+void clCellValue::SetValueDateTime(const wxDateTime& value)
+{
+    DoSetTyped(kTypeDateTime);
+    m_int64Value = value.GetValue().GetValue();
+}
+
+double clCellValue::GetValueDouble() const
+{
+    if(IsDouble()) {
+        return m_doubleValue;
+    }
+    return IsInt64() ? (double)m_int64Value : 0.0;
+}
+
+void clCellValue::ClearFormatCache() const
+{
+    if(IsTyped()) {
+        wxString().swap(m_stringValue);
+        m_formatted = false;
+    }
+}
+
+int clCellValue::Compare(const clCellValue& other) const
+{
+    if(IsTyped() != other.IsTyped()) {
+        return IsTyped() ? -1 : 1;
+    }
+    if(!IsTyped()) {
+        return GetValueString().CmpNoCase(other.GetValueString());
+    }
+    if(IsDouble() || other.IsDouble()) {
+        double a = GetValueDouble();
+        double b = other.GetValueDouble();
+        return (a < b) ? -1 : ((b < a) ? 1 : 0);
+    }
+    // Both are integers or times
+    return (m_int64Value < other.m_int64Value) ? -1 : ((other.m_int64Value < m_int64Value) ? 1 : 0);
+}
+
+void clCellValue::SetBgColour(const wxColour& bgColour)
+{
+    clCellStyle style = GetStyle();
+    style.bgColour = bgColour;
+    m_styleIndex = clCellStyleTable::Get().Intern(style);
+}
 
-void clCellValue::SetValue(const wxString& text) { this->m_stringValue = text; }
+void clCellValue::SetFont(const wxFont& font)
+{
+    clCellStyle style = GetStyle();
+    style.font = font;
+    m_styleIndex = clCellStyleTable::Get().Intern(style);
+}
+
+void clCellValue::SetTextColour(const wxColour& textColour)
+{
+    clCellStyle style = GetStyle();
+    style.textColour = textColour;
+    m_styleIndex = clCellStyleTable::Get().Intern(style);
+}
@@ -1,9 +1,12 @@
 #ifndef CLCELLVALUE_H
 #define CLCELLVALUE_H
 
+#include "clCellStyle.h"
+#include "clMemoryPool.h"
 #include "codelite_exports.h"
 #include <vector>
 #include <wx/colour.h>
+#include <wx/datetime.h>
 #include <wx/font.h>
 #include <wx/string.h>
 
@@ -15,51 +18,85 @@ public:
         kTypeString = 1,
         kTypeBool = 2,
         kTypeChoice = 3,
+        kTypeInt64 = 4,
+        kTypeDouble = 5,
+        kTypeDateTime = 6,
     };
 
 protected:
-    bool m_boolValue = false;
-    wxString m_stringValue;
-    eType m_type = kTypeNull;
+    // For the numeric and time cells, this is the formatted value. It is built on demand (see GetValueString)
+    mutable wxString m_stringValue;
+    union {
+        wxLongLong_t m_int64Value; // kTypeInt64 and kTypeDateTime (milliseconds since the epoch)
+        double m_doubleValue;
+    };
     int m_bitmapIndex = wxNOT_FOUND;
     int m_bitmapSelectedIndex = wxNOT_FOUND;
-    wxFont m_font;
-    wxColour m_textColour;
-    wxColour m_bgColour;
-    wxRect m_checkboxRect;
-    wxRect m_dropDownRect;
+    uint32_t m_styleIndex = 0; // index into clCellStyleTable, 0 is the default style
+    eType m_type = kTypeNull;
+    bool m_boolValue = false;
+    mutable bool m_formatted = false;
+
+    void DoSetTyped(eType type);
 
 public:
     clCellValue();
     clCellValue(const wxString& text, int bmpIndex = wxNOT_FOUND, int bmpOpenIndex = wxNOT_FOUND);
     clCellValue(const char* ptext, int bmpIndex = wxNOT_FOUND, int bmpOpenIndex = wxNOT_FOUND);
     clCellValue(bool bValue, const wxString& label, int bmpIndex = wxNOT_FOUND, int bmpOpenIndex = wxNOT_FOUND);
-    virtual ~clCellValue();
+    ~clCellValue();
     bool IsOk() const { return m_type != kTypeNull; }
     bool IsString() const { return m_type == kTypeString; }
     bool IsBool() const { return m_type == kTypeBool; }
+    bool IsInt64() const { return m_type == kTypeInt64; }
+    bool IsDouble() const { return m_type == kTypeDouble; }
+    bool IsDateTime() const { return m_type == kTypeDateTime; }
+    /**
+     * @brief does this cell hold a native value (number or time) rather than a text?
+     */
+    bool IsTyped() const { return IsInt64() || IsDouble() || IsDateTime(); }
     void SetType(eType type) { m_type = type; }
+    /**
+     * @brief set the text of the cell. A numeric or time cell becomes a text cell
+     */
     void SetValue(const wxString& text);
     void SetValue(bool b) { this->m_boolValue = b; }
+    void SetValueInt64(wxLongLong_t value);
+    void SetValueDouble(double value);
+    void SetValueDateTime(const wxDateTime& value);
+    /**
+     * @brief return the text of the cell. Numeric and time values are formatted on the first call and the result is
+     * kept until the value changes or the cache is cleared (see ClearFormatCache)
+     */
     const wxString& GetValueString() const;
+    wxLongLong_t GetValueInt64() const { return IsInt64() ? m_int64Value : 0; }
+    double GetValueDouble() const;
+    wxDateTime GetValueDateTime() const { return IsDateTime() ? wxDateTime(wxLongLong(m_int64Value)) : wxDateTime(); }
+    /**
+     * @brief release the formatted text of a numeric or time cell
+     */
+    void ClearFormatCache() const;
+    bool IsFormatted() const { return !IsTyped() || m_formatted; }
+    /**
+     * @brief compare two cells: numbers and times by value, texts case insensitive. Numbers and times come before
+     * texts. Return a negative number, zero or a positive number
+     */
+    int Compare(const clCellValue& other) const;
     bool GetValueBool() const { return m_boolValue; }
     bool IsChoice() const { return m_type == kTypeChoice; }
 
     int GetBitmapIndex() const { return m_bitmapIndex; }
     int GetBitmapSelectedIndex() const { return m_bitmapSelectedIndex; }
-    void SetBgColour(const wxColour& bgColour) { this->m_bgColour = bgColour; }
     void SetBitmapIndex(int bitmapIndex) { this->m_bitmapIndex = bitmapIndex; }
     void SetBitmapSelectedIndex(int bitmapSelectedIndex) { this->m_bitmapSelectedIndex = bitmapSelectedIndex; }
-    void SetFont(const wxFont& font) { this->m_font = font; }
-    void SetTextColour(const wxColour& textColour) { this->m_textColour = textColour; }
-    const wxColour& GetBgColour() const { return m_bgColour; }
-    const wxFont& GetFont() const { return m_font; }
-    const wxColour& GetTextColour() const { return m_textColour; }
-    void SetCheckboxRect(const wxRect& checkboxRect) { this->m_checkboxRect = checkboxRect; }
-    const wxRect& GetCheckboxRect() const { return m_checkboxRect; }
-    void SetDropDownRect(const wxRect& dropDownRect) { this->m_dropDownRect = dropDownRect; }
-    const wxRect& GetDropDownRect() const { return m_dropDownRect; }
-    typedef std::vector<clCellValue> Vect_t;
+    void SetBgColour(const wxColour& bgColour);
+    void SetFont(const wxFont& font);
+    void SetTextColour(const wxColour& textColour);
+    const clCellStyle& GetStyle() const { return clCellStyleTable::Get().GetStyle(m_styleIndex); }
+    const wxColour& GetBgColour() const { return GetStyle().bgColour; }
+    const wxFont& GetFont() const { return GetStyle().font; }
+    const wxColour& GetTextColour() const { return GetStyle().textColour; }
+    typedef std::vector<clCellValue, clPoolAllocator<clCellValue>> Vect_t;
 };
 
 #endif // CLCELLVALUE_H
@@ -0,0 +1,234 @@
+#include "clChildrenIndex.h"
+
+uint32_t clChildrenIndex::Priority(Handle_t handle)
+{
+    // The priorities only have to look random: mix the handle bits
+    uint32_t x = handle + 0x9e3779b9u;
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+void clChildrenIndex::Update(Handle_t handle)
+{
+    Node& node = m_nodes[handle];
+    node.count = (uint32_t)(Count(node.left) + Count(node.right) + 1);
+    node.subtreeRows = (uint32_t)(SubtreeRows(node.left) + SubtreeRows(node.right) + node.rows);
+}
+
+void clChildrenIndex::SetLeft(Handle_t handle, Handle_t left)
+{
+    m_nodes[handle].left = left;
+    if(left != kNil) {
+        m_nodes[left].parent = handle;
+    }
+}
+
+void clChildrenIndex::SetRight(Handle_t handle, Handle_t right)
+{
+    m_nodes[handle].right = right;
+    if(right != kNil) {
+        m_nodes[right].parent = handle;
+    }
+}
+
+clChildrenIndex::Handle_t clChildrenIndex::Allocate(size_t rows)
+{
+    Handle_t handle = m_free;
+    if(handle != kNil) {
+        m_free = m_nodes[handle].right;
+        m_nodes[handle] = Node();
+    } else {
+        handle = (Handle_t)m_nodes.size();
+        m_nodes.push_back(Node());
+    }
+    Node& node = m_nodes[handle];
+    node.rows = (uint32_t)rows;
+    node.subtreeRows = (uint32_t)rows;
+    return handle;
+}
+
+void clChildrenIndex::Split(Handle_t tree, size_t count, Handle_t& first, Handle_t& second)
+{
+    if(tree == kNil) {
+        first = second = kNil;
+        return;
+    }
+    size_t leftCount = Count(m_nodes[tree].left);
+    if(count <= leftCount) {
+        Handle_t right = kNil;
+        Split(m_nodes[tree].left, count, first, right);
+        SetLeft(tree, right);
+        second = tree;
+    } else {
+        Handle_t left = kNil;
+        Split(m_nodes[tree].right, count - leftCount - 1, left, second);
+        SetRight(tree, left);
+        first = tree;
+    }
+    Update(tree);
+}
+
+clChildrenIndex::Handle_t clChildrenIndex::Merge(Handle_t first, Handle_t second)
+{
+    if(first == kNil) {
+        return second;
+    }
+    if(second == kNil) {
+        return first;
+    }
+    if(Priority(first) > Priority(second)) {
+        SetRight(first, Merge(m_nodes[first].right, second));
+        Update(first);
+        return first;
+    }
+    SetLeft(second, Merge(first, m_nodes[second].left));
+    Update(second);
+    return second;
+}
+
+void clChildrenIndex::DoInsert(size_t index, Handle_t tree)
+{
+    Handle_t first = kNil;
+    Handle_t second = kNil;
+    Split(m_root, index, first, second);
+    m_root = Merge(Merge(first, tree), second);
+    m_nodes[m_root].parent = kNil;
+}
+
+clChildrenIndex::Handle_t clChildrenIndex::Insert(size_t index, size_t rows)
+{
+    Handle_t handle = Allocate(rows);
+    DoInsert(index, handle);
+    return handle;
+}
+
+void clChildrenIndex::Insert(size_t index, const std::vector<uint32_t>& rows, std::vector<Handle_t>& handles)
+{
+    handles.clear();
+    if(rows.empty()) {
+        return;
+    }
+    handles.reserve(rows.size());
+
+    // Build the tree of the new children in one pass: the stack holds its right spine. A node is complete (and can
+    // be updated) once it leaves the spine
+    std::vector<Handle_t> spine;
+    for(uint32_t r : rows) {
+        Handle_t handle = Allocate(r);
+        handles.push_back(handle);
+        Handle_t last = kNil;
+        while(!spine.empty() && Priority(spine.back()) < Priority(handle)) {
+            last = spine.back();
+            spine.pop_back();
+            Update(last);
+        }
+        SetLeft(handle, last);
+        if(!spine.empty()) {
+            SetRight(spine.back(), handle);
+        }
+        spine.push_back(handle);
+    }
+    while(!spine.empty()) {
+        Update(spine.back());
+        spine.pop_back();
+    }
+    Handle_t tree = handles.front();
+    while(m_nodes[tree].parent != kNil) {
+        tree = m_nodes[tree].parent;
+    }
+    DoInsert(index, tree);
+}
+
+void clChildrenIndex::Erase(size_t index, size_t count)
+{
+    if(count == 0) {
+        return;
+    }
+    Handle_t first = kNil;
+    Handle_t middle = kNil;
+    Handle_t last = kNil;
+    Split(m_root, index, first, middle);
+    Split(middle, count, middle, last);
+    m_root = Merge(first, last);
+    if(m_root != kNil) {
+        m_nodes[m_root].parent = kNil;
+    }
+
+    // Free the erased nodes
+    std::vector<Handle_t> pending;
+    if(middle != kNil) {
+        pending.push_back(middle);
+    }
+    while(!pending.empty()) {
+        Handle_t handle = pending.back();
+        pending.pop_back();
+        Node& node = m_nodes[handle];
+        if(node.left != kNil) {
+            pending.push_back(node.left);
+        }
+        if(node.right != kNil) {
+            pending.push_back(node.right);
+        }
+        node.left = node.parent = kNil;
+        node.right = m_free;
+        m_free = handle;
+    }
+}
+
+void clChildrenIndex::SetRows(Handle_t handle, size_t rows)
+{
+    uint32_t oldRows = m_nodes[handle].rows;
+    m_nodes[handle].rows = (uint32_t)rows;
+    for(Handle_t h = handle; h != kNil; h = m_nodes[h].parent) {
+        m_nodes[h].subtreeRows = m_nodes[h].subtreeRows - oldRows + (uint32_t)rows;
+    }
+}
+
+size_t clChildrenIndex::GetIndex(Handle_t handle) const
+{
+    size_t index = Count(m_nodes[handle].left);
+    for(Handle_t h = handle, parent = m_nodes[h].parent; parent != kNil; h = parent, parent = m_nodes[h].parent) {
+        if(m_nodes[parent].right == h) {
+            index += Count(m_nodes[parent].left) + 1;
+        }
+    }
+    return index;
+}
+
+size_t clChildrenIndex::GetRowsOffset(Handle_t handle) const
+{
+    size_t offset = SubtreeRows(m_nodes[handle].left);
+    for(Handle_t h = handle, parent = m_nodes[h].parent; parent != kNil; h = parent, parent = m_nodes[h].parent) {
+        if(m_nodes[parent].right == h) {
+            offset += SubtreeRows(m_nodes[parent].left) + m_nodes[parent].rows;
+        }
+    }
+    return offset;
+}
+
+size_t clChildrenIndex::FindRowsOffset(size_t& offset) const
+{
+    size_t index = 0;
+    Handle_t h = m_root;
+    while(h != kNil) {
+        const Node& node = m_nodes[h];
+        size_t leftRows = SubtreeRows(node.left);
+        if(offset < leftRows) {
+            h = node.left;
+            continue;
+        }
+        offset -= leftRows;
+        index += Count(node.left);
+        if(offset < node.rows) {
+            return index;
+        }
+        offset -= node.rows;
+        ++index;
+        h = node.right;
+    }
+    return index;
+}
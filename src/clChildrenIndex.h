@@ -0,0 +1,86 @@
+#ifndef CLCHILDRENINDEX_H
+#define CLCHILDRENINDEX_H
+
+#include "codelite_exports.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief the positions and the visible rows offsets of the children of a row. Each child is a node of an implicit
+ * treap (a balanced tree ordered by position) weighted by its visible rows count, and is known by the handle returned
+ * when it was inserted. Finding the position or the rows offset of a child, inserting or erasing children and changing
+ * the rows count of a child are O(log n)
+ */
+class WXDLLIMPEXP_SDK clChildrenIndex
+{
+public:
+    typedef uint32_t Handle_t;
+
+protected:
+    static const Handle_t kNil = (Handle_t)-1;
+    struct Node {
+        Handle_t left = kNil;
+        Handle_t right = kNil;
+        Handle_t parent = kNil;
+        uint32_t count = 1;       // the nodes in this subtree
+        uint32_t rows = 0;        // the visible rows of this child
+        uint32_t subtreeRows = 0; // the visible rows of the children in this subtree
+    };
+    std::vector<Node> m_nodes;
+    Handle_t m_root = kNil;
+    Handle_t m_free = kNil; // the erased nodes, linked by their 'right' member
+
+protected:
+    static uint32_t Priority(Handle_t handle);
+    size_t Count(Handle_t handle) const { return (handle == kNil) ? 0 : m_nodes[handle].count; }
+    size_t SubtreeRows(Handle_t handle) const { return (handle == kNil) ? 0 : m_nodes[handle].subtreeRows; }
+    void Update(Handle_t handle);
+    void SetLeft(Handle_t handle, Handle_t left);
+    void SetRight(Handle_t handle, Handle_t right);
+    Handle_t Allocate(size_t rows);
+    /**
+     * @brief split 'tree' into its first 'count' nodes and the others
+     */
+    void Split(Handle_t tree, size_t count, Handle_t& first, Handle_t& second);
+    Handle_t Merge(Handle_t first, Handle_t second);
+    /**
+     * @brief place 'tree' at 'index'
+     */
+    void DoInsert(size_t index, Handle_t tree);
+
+public:
+    /**
+     * @brief insert a child with 'rows' visible rows at 'index' and return its handle
+     */
+    Handle_t Insert(size_t index, size_t rows);
+    /**
+     * @brief insert the children which visible rows are 'rows' at 'index'. Their handles are returned in 'handles'.
+     * This is O(k + log n) for k children
+     */
+    void Insert(size_t index, const std::vector<uint32_t>& rows, std::vector<Handle_t>& handles);
+    /**
+     * @brief erase the children 'index' to 'index + count - 1'. Their handles may be given to the next inserted ones
+     */
+    void Erase(size_t index, size_t count);
+    /**
+     * @brief the visible rows count of a child has changed
+     */
+    void SetRows(Handle_t handle, size_t rows);
+    /**
+     * @brief return the position of a child
+     */
+    size_t GetIndex(Handle_t handle) const;
+    /**
+     * @brief return the number of visible rows placed before a child
+     */
+    size_t GetRowsOffset(Handle_t handle) const;
+    /**
+     * @brief return the position of the child that contains the row at 'offset', which must be lower than the rows
+     * count of all the children. On return, 'offset' is relative to that child
+     */
+    size_t FindRowsOffset(size_t& offset) const;
+    size_t GetCount() const { return Count(m_root); }
+};
+
+#endif // CLCHILDRENINDEX_H
@@ -1,6 +1,8 @@
 #include "clControlWithItems.h"
 #include "clTreeCtrl.h"
+#include "macros.h"
 #include <cmath>
+#include <cstdlib>
 #include <wx/minifram.h>
 #include <wx/settings.h>
 #include <wx/sizer.h>
@@ -243,7 +245,7 @@ wxRect clControlWithItems::GetItemsRect() const
     return clientRect;
 }
 
-void clControlWithItems::RenderItems(wxDC& dc, const clRowEntry::Vec_t& items)
+void clControlWithItems::RenderItems(wxDC& dc, const clRowEntry::Vec_t& items, const wxRect& area)
 {
     AssignRects(items);
     for(size_t i = 0; i < items.size(); ++i) {
@@ -251,6 +253,9 @@ void clControlWithItems::RenderItems(wxDC& dc, const clRowEntry::Vec_t& items)
         if(curitem->IsHidden()) {
             continue;
         }
+        if(!area.IsEmpty() && !curitem->GetItemRect().Intersects(area)) {
+            continue;
+        }
         if(m_customRenderer) {
             m_customRenderer->Render(this, dc, m_colours, i, curitem);
         } else {
@@ -259,6 +264,171 @@ void clControlWithItems::RenderItems(wxDC& dc, const clRowEntry::Vec_t& items)
     }
 }
 
+void clControlWithItems::RenderItemsBuffered(wxDC& dc, const clRowEntry::Vec_t& items, int firstRow, bool stripes)
+{
+    wxRect rect = GetItemsRect();
+    if(rect.IsEmpty() || (m_lineHeight <= 0)) {
+        // Draw only the rows that need it
+        RenderItems(dc, items, GetUpdateRegion().GetBox());
+        return;
+    }
+    int width = rect.GetWidth();
+    int height = rect.GetHeight();
+    int headerWidth = GetHeader() ? GetHeader()->GetWidth() : 0;
+
+    // How much the pixels painted last time have moved
+    int rows = m_rowsBufferFirstRow - firstRow;
+    int dx = m_rowsBufferFirstColumn - m_firstColumn;
+    int dy = rows * m_lineHeight;
+    bool scrolled = (dx != 0) || (dy != 0);
+    double scale = GetContentScaleFactor();
+    bool reuse = m_rowsBufferValid && m_rowsBuffer.IsOk() && (m_rowsBufferRect == rect) &&
+                 (m_rowsBuffer.GetScaleFactor() == scale) && (m_rowsBufferHeaderWidth == headerWidth) &&
+                 ((dx == 0) || (dy == 0)) && (std::abs(dx) < width) && (std::abs(dy) < height) &&
+                 !(stripes && (rows % 2)) && !(scrolled && !m_rowsBufferDirty.IsEmpty());
+
+    // The areas to draw, in the buffer coordinates
+    std::vector<wxRect> exposed;
+    if(!reuse) {
+        exposed.push_back(wxRect(0, 0, width, height));
+    } else if(dy > 0) {
+        exposed.push_back(wxRect(0, 0, width, dy));
+    } else if(dy < 0) {
+        exposed.push_back(wxRect(0, height + dy, width, -dy));
+    } else if(dx > 0) {
+        exposed.push_back(wxRect(0, 0, dx, height));
+    } else if(dx < 0) {
+        exposed.push_back(wxRect(width + dx, 0, -dx, height));
+    } else {
+        // Only the rows refreshed since the last paint
+        wxRegionIterator iter(m_rowsBufferDirty);
+        for(; iter; ++iter) {
+            wxRect dirty = iter.GetRect();
+            dirty.Offset(-rect.GetX(), -rect.GetY());
+            dirty = dirty.Intersect(wxRect(0, 0, width, height));
+            if(!dirty.IsEmpty()) {
+                exposed.push_back(dirty);
+            }
+        }
+    }
+    m_rowsBufferDirty.Clear();
+
+    if(reuse && scrolled) {
+        // Move the pixels that are still visible into the spare buffer and make it the current one
+        if(!m_rowsBufferSpare.IsOk() || (m_rowsBufferSpare.GetSize() != m_rowsBuffer.GetSize()) ||
+           (m_rowsBufferSpare.GetScaleFactor() != scale)) {
+            m_rowsBufferSpare.CreateScaled(width, height, -1, scale);
+        }
+        {
+            wxMemoryDC fromDC(m_rowsBuffer);
+            wxMemoryDC toDC(m_rowsBufferSpare);
+            toDC.Blit(wxMax(dx, 0), wxMax(dy, 0), width - std::abs(dx), height - std::abs(dy), &fromDC,
+                      wxMax(-dx, 0), wxMax(-dy, 0));
+        }
+        std::swap(m_rowsBuffer, m_rowsBufferSpare);
+    } else if(!reuse) {
+        if(!m_rowsBuffer.IsOk() || (m_rowsBufferRect != rect) || (m_rowsBuffer.GetScaleFactor() != scale)) {
+            m_rowsBuffer.CreateScaled(width, height, -1, scale);
+        }
+    }
+
+    AssignRects(items);
+    if(!exposed.empty()) {
+        wxMemoryDC memDC(m_rowsBuffer);
+        wxGCDC gcdc;
+        wxDC& bufferDC = DoPrepareRowsBufferDC(memDC, gcdc);
+        // Use the same logical coordinates as the window
+        bufferDC.SetDeviceOrigin(-(rect.GetX() + m_firstColumn), -rect.GetY());
+        for(const wxRect& r : exposed) {
+            wxRect area = r;
+            area.Offset(rect.GetX() + m_firstColumn, rect.GetY());
+            bufferDC.SetClippingRegion(area);
+            bufferDC.SetPen(GetColours().GetBgColour());
+            bufferDC.SetBrush(GetColours().GetBgColour());
+            bufferDC.DrawRectangle(area);
+            RenderItems(bufferDC, items, area);
+            bufferDC.DestroyClippingRegion();
+        }
+    }
+
+    // Copy the buffer to the window
+    {
+        wxMemoryDC memDC(m_rowsBuffer);
+        wxPoint origin = dc.GetDeviceOrigin();
+        dc.SetDeviceOrigin(0, 0);
+        dc.Blit(rect.GetX(), rect.GetY(), width, height, &memDC, 0, 0);
+        dc.SetDeviceOrigin(origin.x, origin.y);
+    }
+    m_rowsBufferRect = rect;
+    m_rowsBufferFirstRow = firstRow;
+    m_rowsBufferFirstColumn = m_firstColumn;
+    m_rowsBufferHeaderWidth = headerWidth;
+    m_rowsBufferValid = true;
+}
+
+wxDC& clControlWithItems::DoPrepareRowsBufferDC(wxMemoryDC& memDC, wxGCDC& gcdc)
+{
+#if defined(__WXMSW__) || defined(__WXMAC__)
+    // Like the paint DC, draw through a graphics context
+    gcdc.SetGraphicsContext(wxGraphicsRenderer::GetDefaultRenderer()->CreateContext(memDC));
+    return gcdc;
+#else
+    wxUnusedVar(gcdc);
+    return memDC;
+#endif
+}
+
+void clControlWithItems::Refresh(bool eraseBackground, const wxRect* rect)
+{
+    if(!m_scrollRefresh) {
+        int headerWidth = GetHeader() ? GetHeader()->GetWidth() : 0;
+        if(rect && (headerWidth == m_rowsBufferHeaderWidth)) {
+            m_rowsBufferDirty.Union(*rect);
+        } else {
+            // When the columns were resized all the rows are affected
+            m_rowsBufferValid = false;
+            rect = nullptr;
+        }
+    }
+    clScrolledPanel::Refresh(eraseBackground, rect);
+}
+
+void clControlWithItems::RefreshAfterScroll()
+{
+    m_scrollRefresh = true;
+    Refresh();
+    m_scrollRefresh = false;
+}
+
+void clControlWithItems::DoRefreshRow(clRowEntry* row)
+{
+    CHECK_PTR_RET(row);
+    wxRect clientRect = GetItemsRect();
+    wxRect itemRect = row->GetItemRect();
+    wxRect rect(clientRect.GetX(), itemRect.GetY(), clientRect.GetWidth(), itemRect.GetHeight());
+    rect = rect.Intersect(clientRect);
+    if(!rect.IsEmpty()) {
+        RefreshRect(rect, false);
+    }
+}
+
+void clControlWithItems::DoRefreshRows(int first, int last)
+{
+    if(!m_rowsBufferValid) {
+        // All the rows are drawn by the next paint anyway
+        Refresh();
+        return;
+    }
+    wxRect clientRect = GetItemsRect();
+    int top = clientRect.GetY() + (wxMin(first, last) - m_rowsBufferFirstRow) * m_lineHeight;
+    int bottom = clientRect.GetY() + (wxMax(first, last) - m_rowsBufferFirstRow + 1) * m_lineHeight;
+    wxRect rect(clientRect.GetX(), top, clientRect.GetWidth(), bottom - top);
+    rect = rect.Intersect(clientRect);
+    if(!rect.IsEmpty()) {
+        RefreshRect(rect, false);
+    }
+}
+
 int clControlWithItems::GetNumLineCanFitOnScreen(bool fully_fit) const
 {
     wxRect clientRect = GetItemsRect();
@@ -343,7 +513,7 @@ void clControlWithItems::ScollToColumn(int firstColumn)
 {
     m_firstColumn = firstColumn;
     UpdateScrollBar();
-    Refresh();
+    RefreshAfterScroll();
 }
 
 void clControlWithItems::ScrollColumns(int steps, wxDirection direction)
@@ -364,7 +534,7 @@ void clControlWithItems::ScrollColumns(int steps, wxDirection direction)
         }
         m_firstColumn = firstColumn;
     }
-    Refresh();
+    RefreshAfterScroll();
 }
 
 void clControlWithItems::DoUpdateHeader(clRowEntry* row)
@@ -383,6 +553,10 @@ void clControlWithItems::DoUpdateHeader(clRowEntry* row)
 
     // Use bold font, to get the maximum width needed
     for(size_t i = 0; i < GetHeader()->size(); ++i) {
+        if(!forceUpdate && !GetHeader()->Item(i).IsAutoResize()) {
+            // Don't measure (and format) cells for nothing
+            continue;
+        }
         int row_width = 0;
         if(row) {
             row_width = row->CalcItemWidth(dc, m_lineHeight, i);
@@ -391,9 +565,28 @@ void clControlWithItems::DoUpdateHeader(clRowEntry* row)
             colWidth += 3 * clRowEntry::X_SPACER;
             row_width = colWidth;
         }
-        if(forceUpdate || GetHeader()->Item(i).IsAutoResize()) {
-            GetHeader()->UpdateColWidthIfNeeded(i, row_width, forceUpdate);
+        GetHeader()->UpdateColWidthIfNeeded(i, row_width, forceUpdate);
+    }
+}
+
+void clControlWithItems::DoUpdateHeader(const clRowEntry::Vec_t& rows)
+{
+    if(GetHeader()->empty()) {
+        return;
+    }
+    // Measure all the rows in one pass, using the same DC. The font is set only when it changes
+    wxDC& dc = GetTempDC();
+    for(size_t i = 0; i < GetHeader()->size(); ++i) {
+        if(!GetHeader()->Item(i).IsAutoResize()) {
+            continue;
         }
+        int maxWidth = 0;
+        for(clRowEntry* row : rows) {
+            if(!row->IsHidden()) {
+                maxWidth = wxMax(maxWidth, row->CalcItemWidth(dc, m_lineHeight, i));
+            }
+        }
+        GetHeader()->UpdateColWidthIfNeeded(i, maxWidth, false);
     }
 }
 
@@ -442,25 +635,35 @@ void clControlWithItems::SearchControlDismissed() {}
 void clControlWithItems::AssignRects(const clRowEntry::Vec_t& items)
 {
     wxRect clientRect = GetItemsRect();
-    int y = clientRect.GetY();
     int header_bar_width = m_viewHeader ? m_viewHeader->GetWidth() : wxNOT_FOUND;
-    int width = wxMax(clientRect.GetWidth(), header_bar_width);
-
+    m_rowsTop = clientRect.GetY();
+    m_rowsWidth = wxMax(clientRect.GetWidth(), header_bar_width);
+    m_rowsHeight = m_lineHeight;
+    m_rowsFirstIndex = 0;
     for(size_t i = 0; i < items.size(); ++i) {
         clRowEntry* curitem = items[i];
-        if(curitem->IsHidden()) {
-            // Set the item's rects into something non visible
-            curitem->SetRects(wxRect(-100, -100, 0, 0), wxRect(-100, -100, 0, 0));
-            continue;
+        if(curitem->IsHidden() && (m_rowsFirstIndex == (int)i)) {
+            // A hidden item takes no space
+            m_rowsFirstIndex = i + 1;
         }
-        wxRect itemRect = wxRect(0, y, width, m_lineHeight);
-        wxRect buttonRect;
-        if(curitem->HasChildren()) {
-            buttonRect = wxRect((curitem->GetIndentsCount() * GetIndent()), y, m_lineHeight, m_lineHeight);
-        }
-        curitem->SetRects(itemRect, buttonRect);
-        y += m_lineHeight;
+        curitem->SetOnScreenIndex(i);
+    }
+}
+
+wxRect clControlWithItems::GetRowRect(int index) const
+{
+    if(index < m_rowsFirstIndex) {
+        return wxRect();
+    }
+    return wxRect(0, m_rowsTop + (index - m_rowsFirstIndex) * m_rowsHeight, m_rowsWidth, m_rowsHeight);
+}
+
+int clControlWithItems::GetOnScreenIndexAt(int y) const
+{
+    if((m_rowsHeight <= 0) || (y < m_rowsTop)) {
+        return wxNOT_FOUND;
     }
+    return m_rowsFirstIndex + (y - m_rowsTop) / m_rowsHeight;
 }
 
 void clControlWithItems::DoMouseScroll(const wxMouseEvent& event)
@@ -559,6 +762,7 @@ void clControlWithItems::SetColours(const clColours& colours)
 void clControlWithItems::SetCustomRenderer(clControlWithItemsRowRenderer* renderer)
 {
     m_customRenderer.reset(renderer);
+    m_rowsBufferValid = false;
 }
 
 void clControlWithItems::SetDefaultFont(const wxFont& font)
@@ -7,6 +7,8 @@
 #include "clScrolledPanel.h"
 #include <array>
 #include <memory>
+#include <wx/dcgraph.h>
+#include <wx/dcmemory.h>
 #include <wx/imaglist.h>
 
 #ifdef __WXOSX__
@@ -79,15 +81,71 @@ protected:
     std::unique_ptr<clControlWithItemsRowRenderer> m_customRenderer;
     wxFont m_defaultFont = wxNullFont;
 
+    // The rows area as it was last painted (see RenderItemsBuffered)
+    wxBitmap m_rowsBuffer;
+    wxBitmap m_rowsBufferSpare;
+    wxRect m_rowsBufferRect;
+    int m_rowsBufferFirstRow = 0;
+    int m_rowsBufferFirstColumn = 0;
+    int m_rowsBufferHeaderWidth = 0;
+    wxRegion m_rowsBufferDirty;
+    bool m_rowsBufferValid = false;
+    bool m_scrollRefresh = false;
+
+    // The layout of the on-screen rows (see AssignRects). The rows rects are computed from their on-screen index
+    int m_rowsTop = 0;
+    int m_rowsWidth = 0;
+    int m_rowsHeight = 0;
+    int m_rowsFirstIndex = 0; // the on-screen index of the row drawn at the top (a hidden root takes no space)
+
 protected:
     void DoInitialize();
     int GetNumLineCanFitOnScreen(bool fully_fit = false) const;
     virtual clRowEntry* GetFirstItemOnScreen();
     virtual void SetFirstItemOnScreen(clRowEntry* item);
-    void RenderItems(wxDC& dc, const clRowEntry::Vec_t& items);
+    /**
+     * @brief draw 'items'. When 'area' is not empty, only the rows intersecting it are drawn
+     */
+    void RenderItems(wxDC& dc, const clRowEntry::Vec_t& items, const wxRect& area = wxRect());
+    /**
+     * @brief draw 'items', the visible rows starting at row 'firstRow', through the rows back buffer. If the view was
+     * only scrolled since the last paint (see RefreshAfterScroll), the pixels that are still visible are moved and
+     * only the exposed rows (or columns) are drawn. Set 'stripes' when the rows look depends on their position on
+     * screen (e.g. zebra colouring): the buffer is then reused only when scrolling by an even number of rows
+     */
+    void RenderItemsBuffered(wxDC& dc, const clRowEntry::Vec_t& items, int firstRow, bool stripes);
+    /**
+     * @brief return the DC used for drawing into the rows back buffer
+     */
+    virtual wxDC& DoPrepareRowsBufferDC(wxMemoryDC& memDC, wxGCDC& gcdc);
+    /**
+     * @brief like Refresh() but the only change since the last paint is the scroll position, so the rows back
+     * buffer can be reused
+     */
+    void RefreshAfterScroll();
+    /**
+     * @brief refresh the on screen 'row' only
+     */
+    void DoRefreshRow(clRowEntry* row);
+    /**
+     * @brief refresh the rows 'first' to 'last' (numbered like the 'firstRow' passed to RenderItemsBuffered). Rows
+     * which are not on screen are ignored
+     */
+    void DoRefreshRows(int first, int last);
+    /**
+     * @brief lay out 'items' as the on-screen rows: store the rows area layout and set each row's on-screen index
+     */
     void AssignRects(const clRowEntry::Vec_t& items);
+    /**
+     * @brief return the on-screen index of the row at 'y' (it may be past the last row) or wxNOT_FOUND
+     */
+    int GetOnScreenIndexAt(int y) const;
     void OnSize(wxSizeEvent& event);
     void DoUpdateHeader(clRowEntry* row);
+    /**
+     * @brief same as above for many rows. Every row is measured, the header is updated once per column
+     */
+    void DoUpdateHeader(const clRowEntry::Vec_t& rows);
     wxSize GetTextSize(const wxString& label) const;
     virtual void OnMouseScroll(wxMouseEvent& event);
     virtual bool DoKeyDown(const wxKeyEvent& event);
@@ -104,6 +162,12 @@ public:
     virtual ~clControlWithItems();
     clControlWithItems();
 
+    /**
+     * @brief any refresh, except the ones triggered by scrolling, redraws the rows intersecting 'rect' (all the rows
+     * if 'rect' is null)
+     */
+    void Refresh(bool eraseBackground = true, const wxRect* rect = nullptr) override;
+
     virtual void SetDefaultFont(const wxFont& font);
     virtual wxFont GetDefaultFont() const;
 
@@ -148,6 +212,11 @@ public:
      */
     wxRect GetItemsRect() const;
 
+    /**
+     * @brief return the rect of the row at position 'index' of the on-screen rows, as laid out by the last paint
+     */
+    wxRect GetRowRect(int index) const;
+
     /**
      * @brief draw the header + items
      */
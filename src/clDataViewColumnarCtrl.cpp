@@ -0,0 +1,493 @@
+#include "clDataViewColumnarCtrl.h"
+#include "clParallelSort.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+const size_t kNoRow = (size_t)-1;
+
+// The maximum number of ranges clParallelForRanges can use
+size_t GetMaxRangesCount() { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+wxLongLong_t CellToInt64(const clCellValue& cell)
+{
+    if(cell.IsInt64()) {
+        return cell.GetValueInt64();
+    } else if(cell.IsDouble()) {
+        return (wxLongLong_t)cell.GetValueDouble();
+    } else if(cell.IsDateTime()) {
+        return cell.GetValueDateTime().GetValue().GetValue();
+    } else if(cell.IsBool()) {
+        return cell.GetValueBool() ? 1 : 0;
+    }
+    wxLongLong_t value = 0;
+    return cell.GetValueString().ToLongLong(&value) ? value : 0;
+}
+
+double CellToDouble(const clCellValue& cell)
+{
+    if(cell.IsTyped()) {
+        return cell.IsDouble() ? cell.GetValueDouble() : (double)CellToInt64(cell);
+    }
+    double value = 0.0;
+    return cell.GetValueString().ToDouble(&value) ? value : 0.0;
+}
+
+size_t Int64Length(wxLongLong_t value)
+{
+    size_t len = (value < 0) ? 2 : 1;
+    while(value <= -10 || value >= 10) {
+        value /= 10;
+        ++len;
+    }
+    return len;
+}
+} // namespace
+
+//===---------------------------------------------------
+// clDataViewColumnarModel
+//===---------------------------------------------------
+size_t clDataViewColumnarModel::AddColumn(eColumnType type)
+{
+    // The existing rows get an empty value
+    m_columns.push_back(Column());
+    Column& c = m_columns.back();
+    c.type = type;
+    if(type == kColumnText) {
+        c.offsets.resize(m_storedRows + 1, 0);
+    } else if(type == kColumnDouble) {
+        c.doubles.resize(m_storedRows, 0.0);
+    } else {
+        c.ints.resize(m_storedRows, 0);
+    }
+    return m_columns.size() - 1;
+}
+
+void clDataViewColumnarModel::Reserve(size_t rows)
+{
+    for(Column& c : m_columns) {
+        if(c.type == kColumnText) {
+            c.offsets.reserve(rows + 1);
+        } else if(c.type == kColumnDouble) {
+            c.doubles.reserve(rows);
+        } else {
+            c.ints.reserve(rows);
+        }
+    }
+    m_rows.reserve(rows);
+}
+
+void clDataViewColumnarModel::AppendRow(const std::vector<clCellValue>& cells)
+{
+    static const clCellValue emptyCell("", -1, -1);
+    for(size_t col = 0; col < m_columns.size(); ++col) {
+        Column& c = m_columns[col];
+        const clCellValue& cell = (col < cells.size()) ? cells[col] : emptyCell;
+        switch(c.type) {
+        case kColumnText: {
+            // Dont leave a formatted copy of a typed value in the caller's cell
+            bool formatted = cell.IsFormatted();
+            const wxString& text = cell.GetValueString();
+            const wxChar* chars = text.wc_str();
+            c.text.insert(c.text.end(), chars, chars + text.length());
+            c.offsets.push_back(c.text.size());
+            if(!formatted) {
+                cell.ClearFormatCache();
+            }
+            break;
+        }
+        case kColumnBool:
+            c.ints.push_back(cell.GetValueBool() ? 1 : 0);
+            break;
+        case kColumnDouble:
+            c.doubles.push_back(CellToDouble(cell));
+            break;
+        default:
+            c.ints.push_back(CellToInt64(cell));
+            break;
+        }
+    }
+    m_rows.push_back(m_storedRows++);
+}
+
+void clDataViewColumnarModel::Clear()
+{
+    for(Column& c : m_columns) {
+        eColumnType type = c.type;
+        c = Column();
+        c.type = type;
+        c.offsets.push_back(0);
+    }
+    m_storedRows = 0;
+    m_rows.clear();
+    m_sortColumn = wxNOT_FOUND;
+}
+
+void clDataViewColumnarModel::GetCellValue(size_t row, size_t col, clCellValue& cell) const
+{
+    if(row >= m_rows.size() || col >= m_columns.size()) {
+        return;
+    }
+    size_t storedRow = m_rows[row];
+    const Column& c = m_columns[col];
+    switch(c.type) {
+    case kColumnText:
+        cell.SetValue(GetText(storedRow, col));
+        break;
+    case kColumnBool:
+        cell.SetType(clCellValue::kTypeBool);
+        cell.SetValue(c.ints[storedRow] != 0);
+        break;
+    case kColumnInt64:
+        cell.SetValueInt64(c.ints[storedRow]);
+        break;
+    case kColumnDouble:
+        cell.SetValueDouble(c.doubles[storedRow]);
+        break;
+    case kColumnDateTime:
+        cell.SetValueDateTime(wxDateTime(wxLongLong(c.ints[storedRow])));
+        break;
+    }
+}
+
+wxString clDataViewColumnarModel::GetText(size_t row, size_t col) const
+{
+    const Column& c = m_columns[col];
+    if(c.type != kColumnText) {
+        return DoFormat(row, col);
+    }
+    size_t offset = c.offsets[row];
+    size_t len = c.offsets[row + 1] - offset;
+    return (len == 0) ? wxString() : wxString(c.text.data() + offset, len);
+}
+
+wxLongLong_t clDataViewColumnarModel::GetInt64(size_t row, size_t col) const
+{
+    const Column& c = m_columns[col];
+    if(c.type == kColumnText) {
+        return 0;
+    }
+    return (c.type == kColumnDouble) ? (wxLongLong_t)c.doubles[row] : c.ints[row];
+}
+
+double clDataViewColumnarModel::GetDouble(size_t row, size_t col) const
+{
+    const Column& c = m_columns[col];
+    if(c.type == kColumnText) {
+        return 0.0;
+    }
+    return (c.type == kColumnDouble) ? c.doubles[row] : (double)c.ints[row];
+}
+
+wxString clDataViewColumnarModel::DoFormat(size_t row, size_t col) const
+{
+    const Column& c = m_columns[col];
+    clCellValue cell("", -1, -1);
+    switch(c.type) {
+    case kColumnBool:
+        return (c.ints[row] != 0) ? "1" : "0";
+    case kColumnDouble:
+        cell.SetValueDouble(c.doubles[row]);
+        break;
+    case kColumnDateTime:
+        cell.SetValueDateTime(wxDateTime(wxLongLong(c.ints[row])));
+        break;
+    default:
+        cell.SetValueInt64(c.ints[row]);
+        break;
+    }
+    return cell.GetValueString();
+}
+
+void clDataViewColumnarModel::DoEnsureLowered(size_t col)
+{
+    // The lowered buffer has the same layout as the text buffer, only the new texts need to be lowered
+    Column& c = m_columns[col];
+    size_t start = c.lowered.size();
+    if(c.type != kColumnText || start == c.text.size()) {
+        return;
+    }
+    c.lowered.resize(c.text.size());
+    const wxChar* src = c.text.data() + start;
+    wxChar* dst = c.lowered.data() + start;
+    clParallelForRanges(c.text.size() - start, [src, dst](size_t begin, size_t end, size_t) {
+        for(size_t i = begin; i < end; ++i) {
+            dst[i] = wxTolower(src[i]);
+        }
+    });
+}
+
+bool clDataViewColumnarModel::DoMatches(size_t row, size_t col, const wxString& needle, size_t searchFlags) const
+{
+    const Column& c = m_columns[col];
+    if(c.type != kColumnText) {
+        return clSearchText::Matches(needle, col, DoFormat(row, col), searchFlags);
+    }
+
+    // Compare in place, the needle is already lowered for a case insensitive search
+    const std::vector<wxChar>& buffer = (searchFlags & wxTR_SEARCH_ICASE) ? c.lowered : c.text;
+    const wxChar* first = buffer.data() + c.offsets[row];
+    const wxChar* last = buffer.data() + c.offsets[row + 1];
+    const wxChar* needleFirst = needle.wc_str();
+    const wxChar* needleLast = needleFirst + needle.length();
+    if(searchFlags & wxTR_SEARCH_METHOD_CONTAINS) {
+        return needle.empty() || (std::search(first, last, needleFirst, needleLast) != last);
+    }
+    return ((size_t)(last - first) == needle.length()) && std::equal(first, last, needleFirst);
+}
+
+void clDataViewColumnarModel::Sort(size_t col, bool ascending)
+{
+    if(col >= m_columns.size()) {
+        return;
+    }
+    m_sortColumn = col;
+    m_sortAscending = ascending;
+    if(m_rows.size() < 2) {
+        return;
+    }
+    Column& c = m_columns[col];
+    if(c.type == kColumnText) {
+        DoEnsureLowered(col);
+        const wxChar* text = c.lowered.data();
+        const size_t* offsets = c.offsets.data();
+        auto lessThan = [text, offsets](size_t a, size_t b) {
+            return std::lexicographical_compare(text + offsets[a], text + offsets[a + 1], text + offsets[b],
+                                                text + offsets[b + 1]);
+        };
+        if(ascending) {
+            clParallelStableSort(m_rows.begin(), m_rows.end(), lessThan);
+        } else {
+            clParallelStableSort(m_rows.begin(), m_rows.end(),
+                                 [&lessThan](size_t a, size_t b) { return lessThan(b, a); });
+        }
+    } else if(c.type == kColumnDouble) {
+        const double* values = c.doubles.data();
+        if(ascending) {
+            clParallelStableSort(m_rows.begin(), m_rows.end(),
+                                 [values](size_t a, size_t b) { return values[a] < values[b]; });
+        } else {
+            clParallelStableSort(m_rows.begin(), m_rows.end(),
+                                 [values](size_t a, size_t b) { return values[b] < values[a]; });
+        }
+    } else {
+        const wxLongLong_t* values = c.ints.data();
+        if(ascending) {
+            clParallelStableSort(m_rows.begin(), m_rows.end(),
+                                 [values](size_t a, size_t b) { return values[a] < values[b]; });
+        } else {
+            clParallelStableSort(m_rows.begin(), m_rows.end(),
+                                 [values](size_t a, size_t b) { return values[b] < values[a]; });
+        }
+    }
+}
+
+void clDataViewColumnarModel::Filter(const FilterFunc_t& accept)
+{
+    // Each range keeps its accepted rows, the ranges are then joined in order
+    std::vector<std::vector<size_t>> accepted(GetMaxRangesCount());
+    const std::vector<size_t>& rows = m_rows;
+    size_t rangesCount = clParallelForRanges(rows.size(), [&](size_t begin, size_t end, size_t index) {
+        std::vector<size_t>& kept = accepted[index];
+        for(size_t i = begin; i < end; ++i) {
+            if(accept(*this, rows[i])) {
+                kept.push_back(rows[i]);
+            }
+        }
+    });
+
+    std::vector<size_t> filtered;
+    if(rangesCount == 1) {
+        filtered.swap(accepted[0]);
+    } else {
+        size_t count = 0;
+        for(size_t i = 0; i < rangesCount; ++i) {
+            count += accepted[i].size();
+        }
+        filtered.reserve(count);
+        for(size_t i = 0; i < rangesCount; ++i) {
+            filtered.insert(filtered.end(), accepted[i].begin(), accepted[i].end());
+        }
+    }
+    m_rows.swap(filtered);
+}
+
+void clDataViewColumnarModel::Filter(size_t col, const wxString& what, size_t searchFlags)
+{
+    if(col >= m_columns.size()) {
+        return;
+    }
+    if(searchFlags & wxTR_SEARCH_ICASE) {
+        DoEnsureLowered(col);
+    }
+    wxString needle = (searchFlags & wxTR_SEARCH_ICASE) ? what.Lower() : what;
+    Filter([&](const clDataViewColumnarModel& model, size_t row) {
+        return model.DoMatches(row, col, needle, searchFlags);
+    });
+}
+
+void clDataViewColumnarModel::ClearFilter()
+{
+    m_rows.resize(m_storedRows);
+    for(size_t i = 0; i < m_storedRows; ++i) {
+        m_rows[i] = i;
+    }
+    // The filter dropped rows but kept the sorted order, restore it for all the rows
+    if(m_sortColumn != wxNOT_FOUND) {
+        Sort(m_sortColumn, m_sortAscending);
+    }
+}
+
+int clDataViewColumnarModel::FindRow(size_t col, const wxString& what, size_t from, size_t searchFlags)
+{
+    if(col >= m_columns.size()) {
+        return wxNOT_FOUND;
+    }
+    if(searchFlags & wxTR_SEARCH_ICASE) {
+        DoEnsureLowered(col);
+    }
+    wxString needle = (searchFlags & wxTR_SEARCH_ICASE) ? what.Lower() : what;
+
+    // Search window after window, so a match close to 'from' does not scan all the rows. Each window is split between
+    // the cores, the first range with a match wins
+    const size_t windowSize = 32768 * GetMaxRangesCount();
+    std::vector<size_t> found(GetMaxRangesCount());
+    for(size_t windowStart = from; windowStart < m_rows.size(); windowStart += windowSize) {
+        size_t count = std::min(windowSize, m_rows.size() - windowStart);
+        std::fill(found.begin(), found.end(), kNoRow);
+        size_t rangesCount = clParallelForRanges(count, [&](size_t begin, size_t end, size_t index) {
+            for(size_t i = windowStart + begin; i < windowStart + end; ++i) {
+                if(DoMatches(m_rows[i], col, needle, searchFlags)) {
+                    found[index] = i;
+                    break;
+                }
+            }
+        });
+        for(size_t i = 0; i < rangesCount; ++i) {
+            if(found[i] != kNoRow) {
+                return found[i];
+            }
+        }
+    }
+    return wxNOT_FOUND;
+}
+
+int clDataViewColumnarModel::GetLongestRow(size_t col) const
+{
+    if(m_rows.empty() || col >= m_columns.size()) {
+        return wxNOT_FOUND;
+    }
+    const Column& c = m_columns[col];
+    std::function<size_t(size_t)> length;
+    switch(c.type) {
+    case kColumnText:
+        length = [&c](size_t row) { return c.offsets[row + 1] - c.offsets[row]; };
+        break;
+    case kColumnInt64:
+        length = [&c](size_t row) { return Int64Length(c.ints[row]); };
+        break;
+    case kColumnDouble:
+        // Only used to pick the row, the row itself is measured with the cell formatting
+        length = [&c](size_t row) {
+            char buffer[64];
+            return (size_t)std::max(snprintf(buffer, sizeof(buffer), "%g", c.doubles[row]), 0);
+        };
+        break;
+    default:
+        // Booleans and times are drawn with the same width
+        return 0;
+    }
+
+    // Each range finds its longest row, ties go to the first row
+    std::vector<std::pair<size_t, size_t>> longest(GetMaxRangesCount(), { 0, kNoRow });
+    size_t rangesCount = clParallelForRanges(m_rows.size(), [&](size_t begin, size_t end, size_t index) {
+        std::pair<size_t, size_t> best(0, kNoRow);
+        for(size_t i = begin; i < end; ++i) {
+            size_t len = length(m_rows[i]);
+            if(best.second == kNoRow || len > best.first) {
+                best = { len, i };
+            }
+        }
+        longest[index] = best;
+    });
+    std::pair<size_t, size_t> best = longest[0];
+    for(size_t i = 1; i < rangesCount; ++i) {
+        if(longest[i].first > best.first) {
+            best = longest[i];
+        }
+    }
+    return (int)best.second;
+}
+
+//===---------------------------------------------------
+// clDataViewColumnarCtrl
+//===---------------------------------------------------
+clDataViewColumnarCtrl::clDataViewColumnarCtrl(wxWindow* parent, wxWindowID id, const wxPoint& pos, const wxSize& size,
+                                               long style)
+    : clDataViewListCtrl(parent, id, pos, size, style)
+{
+    SetVirtualListModel(&m_rows);
+}
+
+clDataViewColumnarCtrl::~clDataViewColumnarCtrl() {}
+
+void clDataViewColumnarCtrl::AppendColumn(const wxString& label, clDataViewColumnarModel::eColumnType type, int width)
+{
+    AppendTextColumn(label, wxDATAVIEW_CELL_INERT, width);
+    m_rows.AddColumn(type);
+}
+
+void clDataViewColumnarCtrl::DeleteAllRows()
+{
+    m_rows.Clear();
+    UnselectAll();
+    RefreshVirtualRows();
+}
+
+void clDataViewColumnarCtrl::SortByColumn(size_t col, bool ascending)
+{
+    m_rows.Sort(col, ascending);
+    UnselectAll();
+    RefreshVirtualRows();
+}
+
+void clDataViewColumnarCtrl::FilterRows(size_t col, const wxString& what, size_t searchFlags)
+{
+    m_rows.Filter(col, what, searchFlags);
+    UnselectAll();
+    RefreshVirtualRows();
+}
+
+void clDataViewColumnarCtrl::ClearFilter()
+{
+    m_rows.ClearFilter();
+    UnselectAll();
+    RefreshVirtualRows();
+}
+
+void clDataViewColumnarCtrl::FitColumnsWidth()
+{
+    if(GetHeader()->empty() || m_rows.GetRowCount() == 0) {
+        return;
+    }
+
+    // Put the longest value of each column in a drawing slot and measure it. The slot is bound again on the next paint
+    clRowEntry::Vec_t slots;
+    DoGetVirtualSlots(1, slots);
+    if(slots.empty()) {
+        return;
+    }
+    clRowEntry* slot = slots[0];
+    slot->SetListItem(true);
+    for(size_t col = 0; col < GetHeader()->size(); ++col) {
+        clCellValue cell("", -1, -1);
+        int row = m_rows.GetLongestRow(col);
+        if(row != wxNOT_FOUND) {
+            m_rows.GetCellValue(row, col, cell);
+        }
+        slot->SetCellValue(cell, col);
+    }
+    clControlWithItems::DoUpdateHeader(slot);
+    Refresh();
+}
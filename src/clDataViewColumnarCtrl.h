@@ -0,0 +1,166 @@
+#ifndef CLDATAVIEWCOLUMNARCTRL_H
+#define CLDATAVIEWCOLUMNARCTRL_H
+
+#include "clDataViewListCtrl.h"
+#include <functional>
+#include <vector>
+
+/**
+ * @brief column-major rows storage for clDataViewListCtrl in virtual mode. The values of a column are kept in
+ * contiguous arrays: the texts one after the other in a single buffer (plus an offsets array), numbers, booleans and
+ * times as native values. Column wide operations (sort, filter, search, width measurement) go through these arrays
+ * linearly and are split between all the cores.
+ * The displayed rows are indices into the stored rows: sorting and filtering only reorder the indices
+ */
+class WXDLLIMPEXP_SDK clDataViewColumnarModel : public clDataViewListVirtualModel
+{
+public:
+    enum eColumnType {
+        kColumnText = 0,
+        kColumnBool,
+        kColumnInt64,
+        kColumnDouble,
+        kColumnDateTime, // stored as milliseconds since the epoch
+    };
+
+    /**
+     * @brief filter callback, 'row' is a stored row index (see GetStoredRow)
+     */
+    typedef std::function<bool(const clDataViewColumnarModel& model, size_t row)> FilterFunc_t;
+
+protected:
+    struct Column {
+        eColumnType type = kColumnText;
+        std::vector<wxChar> text;       // kColumnText: the texts, one after the other
+        std::vector<size_t> offsets;    // kColumnText: text 'i' is [offsets[i], offsets[i + 1])
+        std::vector<wxChar> lowered;    // kColumnText: lowered copy of 'text', built on demand
+        std::vector<wxLongLong_t> ints; // kColumnBool, kColumnInt64 and kColumnDateTime
+        std::vector<double> doubles;    // kColumnDouble
+    };
+    std::vector<Column> m_columns;
+    size_t m_storedRows = 0;
+    std::vector<size_t> m_rows;     // the displayed rows, as stored rows indices
+    int m_sortColumn = wxNOT_FOUND; // the column of the last Sort(), applied again by ClearFilter
+    bool m_sortAscending = true;
+
+protected:
+    void DoEnsureLowered(size_t col);
+    wxString DoFormat(size_t row, size_t col) const;
+    bool DoMatches(size_t row, size_t col, const wxString& needle, size_t searchFlags) const;
+
+public:
+    clDataViewColumnarModel() {}
+    virtual ~clDataViewColumnarModel() {}
+
+    size_t GetRowCount() const override { return m_rows.size(); }
+    void GetCellValue(size_t row, size_t col, clCellValue& cell) const override;
+
+    /**
+     * @brief add a column and return its index. The existing rows get an empty value (or 0) in this column
+     */
+    size_t AddColumn(eColumnType type);
+    size_t GetColumnCount() const { return m_columns.size(); }
+    eColumnType GetColumnType(size_t col) const { return m_columns[col].type; }
+
+    void Reserve(size_t rows);
+    /**
+     * @brief append a row. The cells are converted to the columns types, missing cells are left empty (or 0). The new
+     * row is displayed last, whatever the current sort or filter are
+     */
+    void AppendRow(const std::vector<clCellValue>& cells);
+    /**
+     * @brief delete all the rows, the columns are kept. The sort order is forgotten
+     */
+    void Clear();
+
+    /**
+     * @brief return the stored row index of a displayed row
+     */
+    size_t GetStoredRow(size_t row) const { return m_rows[row]; }
+    size_t GetStoredRowCount() const { return m_storedRows; }
+
+    // Accessors by stored row index
+    wxString GetText(size_t row, size_t col) const;
+    wxLongLong_t GetInt64(size_t row, size_t col) const;
+    double GetDouble(size_t row, size_t col) const;
+
+    /**
+     * @brief stable sort the displayed rows by column 'col'. Texts are sorted case insensitive, numbers and times by
+     * value
+     */
+    void Sort(size_t col, bool ascending = true);
+    /**
+     * @brief keep only the displayed rows accepted by 'accept'. The callback is called from several threads at once
+     */
+    void Filter(const FilterFunc_t& accept);
+    /**
+     * @brief keep only the displayed rows whose column 'col' matches 'what' (see wxTR_SEARCH* for the flags)
+     */
+    void Filter(size_t col, const wxString& what, size_t searchFlags = wxTR_SEARCH_DEFAULT);
+    /**
+     * @brief display all the stored rows, sorted like the last call to Sort() did (or in their insertion order)
+     */
+    void ClearFilter();
+    /**
+     * @brief return the first displayed row, starting at row 'from', whose column 'col' matches 'what' (see
+     * wxTR_SEARCH* for the flags) or wxNOT_FOUND
+     */
+    int FindRow(size_t col, const wxString& what, size_t from = 0, size_t searchFlags = wxTR_SEARCH_DEFAULT);
+    /**
+     * @brief return the displayed row with the longest text in column 'col' (the row to measure when fitting the
+     * column width), or wxNOT_FOUND if there are no rows
+     */
+    int GetLongestRow(size_t col) const;
+};
+
+/**
+ * @brief a clDataViewListCtrl displaying a clDataViewColumnarModel, e.g.:
+ * clDataViewColumnarCtrl ctrl(parent);
+ * ctrl.AppendColumn("Name", clDataViewColumnarModel::kColumnText);
+ * ctrl.AppendColumn("Size", clDataViewColumnarModel::kColumnInt64);
+ * ctrl.GetRows().AppendRow(cells); ...
+ * ctrl.RefreshVirtualRows();
+ * The control runs in virtual mode, rows are accessed by their displayed index
+ */
+class WXDLLIMPEXP_SDK clDataViewColumnarCtrl : public clDataViewListCtrl
+{
+protected:
+    clDataViewColumnarModel m_rows;
+
+public:
+    clDataViewColumnarCtrl(wxWindow* parent, wxWindowID id = wxID_ANY, const wxPoint& pos = wxDefaultPosition,
+                           const wxSize& size = wxDefaultSize, long style = 0);
+    virtual ~clDataViewColumnarCtrl();
+
+    /**
+     * @brief direct access to the rows. Call RefreshVirtualRows() after modifying them
+     */
+    clDataViewColumnarModel& GetRows() { return m_rows; }
+    const clDataViewColumnarModel& GetRows() const { return m_rows; }
+
+    /**
+     * @brief add a column to both the header and the model
+     */
+    void AppendColumn(const wxString& label, clDataViewColumnarModel::eColumnType type,
+                      int width = wxCOL_WIDTH_AUTOSIZE);
+
+    void DeleteAllRows();
+
+    /**
+     * @brief sort the rows by column 'col'. The selection (which is made of row indexes) is cleared
+     */
+    void SortByColumn(size_t col, bool ascending = true);
+    /**
+     * @brief show only the rows whose column 'col' matches 'what'. The selection is cleared
+     */
+    void FilterRows(size_t col, const wxString& what, size_t searchFlags = wxTR_SEARCH_DEFAULT);
+    void ClearFilter();
+
+    /**
+     * @brief fit the auto-resize columns to their longest value, over all the rows (and not only the rows painted so
+     * far)
+     */
+    void FitColumnsWidth();
+};
+
+#endif // CLDATAVIEWCOLUMNARCTRL_H
@@ -1,5 +1,6 @@
 #include "clDataViewListCtrl.h"
 #include "clHeaderItem.h"
+#include "clParallelSort.h"
 #include <algorithm>
 #include <wx/dataview.h>
 #include <wx/dcbuffer.h>
@@ -10,6 +11,17 @@
 #define DV_ITEM(tree_item) wxDataViewItem(tree_item.GetID())
 #define TREE_ITEM(dv_item) wxTreeItemId(dv_item.GetID())
 
+// The item based API can not be used when the rows are provided by a virtual model
+#define CHECK_NOT_VIRTUAL_RET() \
+    if(IsVirtualList()) {       \
+        return;                 \
+    }
+
+#define CHECK_NOT_VIRTUAL_RET_VAL(val) \
+    if(IsVirtualList()) {              \
+        return val;                    \
+    }
+
 wxIMPLEMENT_DYNAMIC_CLASS(clDataViewTextBitmap, wxObject);
 IMPLEMENT_VARIANT_OBJECT_EXPORTED(clDataViewTextBitmap, WXDLLIMPEXP_SDK);
 
@@ -69,6 +81,13 @@ clDataViewListCtrl::clDataViewListCtrl(wxWindow* parent, wxWindowID id, const wx
     Bind(wxEVT_TREE_SEARCH_TEXT, &clDataViewListCtrl::OnConvertEvent, this);
     Bind(wxEVT_TREE_CLEAR_SEARCH, &clDataViewListCtrl::OnConvertEvent, this);
 
+    // In virtual mode, the mouse is handled here (these are called before the clTreeCtrl handlers)
+    Bind(wxEVT_LEFT_DOWN, &clDataViewListCtrl::OnVirtualLeftDown, this);
+    Bind(wxEVT_LEFT_DCLICK, &clDataViewListCtrl::OnVirtualLeftDClick, this);
+    Bind(wxEVT_CONTEXT_MENU, &clDataViewListCtrl::OnVirtualContextMenu, this);
+
+    // Lists tend to be large, allocate the rows from a pool
+    m_model.EnableMemoryPool(true);
     AddRoot("Hidden Root", -1, -1, nullptr);
 }
 
@@ -81,10 +100,14 @@ clDataViewListCtrl::~clDataViewListCtrl()
     Unbind(wxEVT_TREE_ITEM_ACTIVATED, &clDataViewListCtrl::OnConvertEvent, this);
     Unbind(wxEVT_TREE_ITEM_MENU, &clDataViewListCtrl::OnConvertEvent, this);
     Unbind(wxEVT_TREE_ITEM_VALUE_CHANGED, &clDataViewListCtrl::OnConvertEvent, this);
+    Unbind(wxEVT_LEFT_DOWN, &clDataViewListCtrl::OnVirtualLeftDown, this);
+    Unbind(wxEVT_LEFT_DCLICK, &clDataViewListCtrl::OnVirtualLeftDClick, this);
+    Unbind(wxEVT_CONTEXT_MENU, &clDataViewListCtrl::OnVirtualContextMenu, this);
 }
 
 void clDataViewListCtrl::AppendItem(const wxVector<wxVariant>& values, wxUIntPtr data)
 {
+    CHECK_NOT_VIRTUAL_RET();
     wxTreeItemId item = clTreeCtrl::AppendItem(GetRootItem(), "", -1, -1, nullptr);
     clRowEntry* child = m_model.ToPtr(item);
     // mark this row as a "list-view" row (i.e. it can't have children)
@@ -97,6 +120,45 @@ void clDataViewListCtrl::AppendItem(const wxVector<wxVariant>& values, wxUIntPtr
     UpdateScrollBar();
 }
 
+clRowEntry* clDataViewListCtrl::DoCreateRow(const std::vector<clCellValue>& cells, wxUIntPtr data)
+{
+    clRowEntry* row = new(m_model.GetMemoryPool()) clRowEntry(this, "", -1, -1);
+    row->SetListItem(true);
+    row->SetData(data);
+    for(size_t col = 0; col < cells.size(); ++col) {
+        row->SetCellValue(cells[col], col);
+    }
+    return row;
+}
+
+void clDataViewListCtrl::AppendItem(const std::vector<clCellValue>& cells, wxUIntPtr data)
+{
+    CHECK_NOT_VIRTUAL_RET();
+    clRowEntry* row = DoCreateRow(cells, data);
+    m_model.AddRows(GetRootItem(), { row });
+    clControlWithItems::DoUpdateHeader(row);
+    UpdateScrollBar();
+    Refresh();
+}
+
+void clDataViewListCtrl::AppendItems(const std::vector<std::vector<clCellValue>>& rows,
+                                     const std::vector<wxUIntPtr>* data)
+{
+    CHECK_NOT_VIRTUAL_RET();
+    if(rows.empty()) {
+        return;
+    }
+    clRowEntry::Vec_t newRows;
+    newRows.reserve(rows.size());
+    for(size_t i = 0; i < rows.size(); ++i) {
+        newRows.push_back(DoCreateRow(rows[i], (data && (i < data->size())) ? (*data)[i] : 0));
+    }
+    m_model.AddRows(GetRootItem(), newRows);
+    clControlWithItems::DoUpdateHeader(newRows);
+    UpdateScrollBar();
+    Refresh();
+}
+
 wxDataViewColumn* clDataViewListCtrl::AppendIconTextColumn(const wxString& label, wxDataViewCellMode mode, int width,
                                                            wxAlignment align, int flags)
 {
@@ -127,8 +189,29 @@ wxDataViewColumn* clDataViewListCtrl::AppendTextColumn(const wxString& label, wx
     return nullptr;
 }
 
+void clDataViewListCtrl::DoGetBatchSelections(wxArrayTreeItemIds& items) const
+{
+    if(!IsVirtualList()) {
+        clTreeCtrl::DoGetBatchSelections(items);
+        return;
+    }
+    for(const clRowRanges::const_iterator::value_type& range : m_virtualListSelection) {
+        for(size_t row = range.first; row <= range.second; ++row) {
+            items.Add(TREE_ITEM(RowToItem(row)));
+        }
+    }
+}
+
 int clDataViewListCtrl::GetSelections(wxDataViewItemArray& sel) const
 {
+    if(IsVirtualList()) {
+        for(const clRowRanges::const_iterator::value_type& range : m_virtualListSelection) {
+            for(size_t row = range.first; row <= range.second; ++row) {
+                sel.Add(RowToItem(row));
+            }
+        }
+        return sel.size();
+    }
     wxArrayTreeItemIds items;
     clTreeCtrl::GetSelections(items);
     for(size_t i = 0; i < items.size(); ++i) {
@@ -137,7 +220,29 @@ int clDataViewListCtrl::GetSelections(wxDataViewItemArray& sel) const
     return sel.size();
 }
 
-int clDataViewListCtrl::GetSelectedItemsCount() const { return m_model.GetSelectionsCount(); }
+int clDataViewListCtrl::GetSelectedItemsCount() const
+{
+    if(IsVirtualList()) {
+        return m_virtualListSelection.GetRowsCount();
+    }
+    return m_model.GetSelectionsCount();
+}
+
+wxDataViewItem clDataViewListCtrl::GetSelection() const
+{
+    if(IsVirtualList()) {
+        return m_virtualListSelection.IsEmpty() ? wxDataViewItem() : RowToItem(m_virtualListSelection.GetFirstRow());
+    }
+    return wxDataViewItem(clTreeCtrl::GetSelection().GetID());
+}
+
+wxDataViewItem clDataViewListCtrl::GetCurrentItem() const
+{
+    if(IsVirtualList()) {
+        return (m_virtualCurrentRow == wxNOT_FOUND) ? wxDataViewItem() : RowToItem(m_virtualCurrentRow);
+    }
+    return wxDataViewItem(GetFocusedItem().GetID());
+}
 
 void clDataViewListCtrl::OnConvertEvent(wxTreeEvent& event)
 {
@@ -170,11 +275,16 @@ void clDataViewListCtrl::OnConvertEvent(wxTreeEvent& event)
 
 bool clDataViewListCtrl::SendDataViewEvent(const wxEventType& type, wxTreeEvent& treeEvent, const wxString& text)
 {
+    wxDataViewItem item = DV_ITEM(treeEvent.GetItem());
+    if(IsVirtualList() && item.IsOk()) {
+        // In virtual mode, the tree item is a slot. Report the row it displays
+        item = RowToItem(m_model.ToPtr(treeEvent.GetItem())->GetData());
+    }
 #if wxCHECK_VERSION(3, 1, 0)
-    wxDataViewEvent e(type, &m_dummy, DV_ITEM(treeEvent.GetItem()));
+    wxDataViewEvent e(type, &m_dummy, item);
 #else
     wxDataViewEvent e(type);
-    e.SetItem(DV_ITEM(treeEvent.GetItem()));
+    e.SetItem(item);
 #endif
     e.SetEventObject(this);
     e.SetColumn(treeEvent.GetInt());
@@ -188,9 +298,19 @@ bool clDataViewListCtrl::SendDataViewEvent(const wxEventType& type, wxTreeEvent&
 
 void clDataViewListCtrl::DeleteAllItems(const std::function<void(wxUIntPtr)>& deleterFunc)
 {
+    // In virtual mode the rows are owned by the model
+    m_virtualCurrentRow = wxNOT_FOUND;
+    m_virtualAnchorRow = wxNOT_FOUND;
+    if(!m_virtualListSelection.IsEmpty()) {
+        m_virtualListSelection.Clear();
+        NotifySelectionChanged();
+    }
+    m_sortKeys.clear();
+    m_sortColumn = wxNOT_FOUND;
+
     // If a deleter was provided, call it per user's item data
-    if(deleterFunc && m_model.GetRoot()) {
-        clRowEntry::Vec_t& children = m_model.GetRoot()->GetChildren();
+    if(deleterFunc && m_model.GetRoot() && !IsVirtualList()) {
+        const clRowEntry::Vec_t& children = m_model.GetRoot()->GetChildren();
         for(size_t i = 0; i < children.size(); ++i) {
             wxUIntPtr userData = children[i]->GetData();
             if(userData) {
@@ -206,6 +326,7 @@ void clDataViewListCtrl::DeleteAllItems(const std::function<void(wxUIntPtr)>& de
 
 wxDataViewItem clDataViewListCtrl::AppendItem(const wxString& text, int image, int selImage, wxUIntPtr data)
 {
+    CHECK_NOT_VIRTUAL_RET_VAL(wxDataViewItem());
     wxTreeItemId child = clTreeCtrl::AppendItem(GetRootItem(), text, image, selImage, nullptr);
     // mark this row as a "list-view" row (i.e. it can't have children)
     m_model.ToPtr(child)->SetListItem(true);
@@ -218,6 +339,7 @@ wxDataViewItem clDataViewListCtrl::AppendItem(const wxString& text, int image, i
 wxDataViewItem clDataViewListCtrl::InsertItem(const wxDataViewItem& previous, const wxString& text, int image,
                                               int selImage, wxUIntPtr data)
 {
+    CHECK_NOT_VIRTUAL_RET_VAL(wxDataViewItem());
     wxTreeItemId child =
         clTreeCtrl::InsertItem(GetRootItem(), wxTreeItemId(previous.GetID()), text, image, selImage, nullptr);
     // mark this row as a "list-view" row (i.e. it can't have children)
@@ -229,58 +351,82 @@ wxDataViewItem clDataViewListCtrl::InsertItem(const wxDataViewItem& previous, co
 
 wxUIntPtr clDataViewListCtrl::GetItemData(const wxDataViewItem& item) const
 {
+    CHECK_NOT_VIRTUAL_RET_VAL(0);
     clRowEntry* r = m_model.ToPtr(TREE_ITEM(item));
     return r->GetData();
 }
 
 void clDataViewListCtrl::SetItemData(const wxDataViewItem& item, wxUIntPtr data)
 {
+    CHECK_NOT_VIRTUAL_RET();
     clRowEntry* r = m_model.ToPtr(TREE_ITEM(item));
     r->SetData(data);
 }
 
 void clDataViewListCtrl::SetItemBackgroundColour(const wxDataViewItem& item, const wxColour& colour, size_t col)
 {
+    CHECK_NOT_VIRTUAL_RET();
     clTreeCtrl::SetItemBackgroundColour(TREE_ITEM(item), colour, col);
 }
 
 wxColour clDataViewListCtrl::GetItemBackgroundColour(const wxDataViewItem& item, size_t col) const
 {
+    if(IsVirtualList()) {
+        clCellValue cell;
+        return DoGetVirtualCell(item, col, cell) ? cell.GetBgColour() : wxColour();
+    }
     return clTreeCtrl::GetItemBackgroundColour(TREE_ITEM(item), col);
 }
 
 void clDataViewListCtrl::SetItemTextColour(const wxDataViewItem& item, const wxColour& colour, size_t col)
 {
+    CHECK_NOT_VIRTUAL_RET();
     clTreeCtrl::SetItemTextColour(TREE_ITEM(item), colour, col);
 }
 
 wxColour clDataViewListCtrl::GetItemTextColour(const wxDataViewItem& item, size_t col) const
 {
+    if(IsVirtualList()) {
+        clCellValue cell;
+        return DoGetVirtualCell(item, col, cell) ? cell.GetTextColour() : wxColour();
+    }
     return clTreeCtrl::GetItemTextColour(TREE_ITEM(item), col);
 }
 
 void clDataViewListCtrl::SetItemText(const wxDataViewItem& item, const wxString& text, size_t col)
 {
+    CHECK_NOT_VIRTUAL_RET();
+    m_sortColumn = wxNOT_FOUND; // the sort keys are outdated
     clTreeCtrl::SetItemText(TREE_ITEM(item), text, col);
 }
 
 wxString clDataViewListCtrl::GetItemText(const wxDataViewItem& item, size_t col) const
 {
+    if(IsVirtualList()) {
+        clCellValue cell;
+        return DoGetVirtualCell(item, col, cell) ? cell.GetValueString() : wxString();
+    }
     return clTreeCtrl::GetItemText(TREE_ITEM(item), col);
 }
 
 void clDataViewListCtrl::SetItemBold(const wxDataViewItem& item, bool bold, size_t col)
 {
+    CHECK_NOT_VIRTUAL_RET();
     clTreeCtrl::SetItemBold(TREE_ITEM(item), bold, col);
 }
 
 void clDataViewListCtrl::SetItemFont(const wxDataViewItem& item, const wxFont& font, size_t col)
 {
+    CHECK_NOT_VIRTUAL_RET();
     clTreeCtrl::SetItemFont(TREE_ITEM(item), font, col);
 }
 
 wxFont clDataViewListCtrl::GetItemFont(const wxDataViewItem& item, size_t col) const
 {
+    if(IsVirtualList()) {
+        clCellValue cell;
+        return DoGetVirtualCell(item, col, cell) ? cell.GetFont() : wxFont();
+    }
     return clTreeCtrl::GetItemFont(TREE_ITEM(item), col);
 }
 
@@ -302,6 +448,9 @@ clHeaderItem* clDataViewListCtrl::GetColumn(size_t index)
 
 size_t clDataViewListCtrl::GetItemCount() const
 {
+    if(IsVirtualList()) {
+        return m_virtualListModel->GetRowCount();
+    }
     clRowEntry* root = m_model.GetRoot();
     if(!root) {
         return 0;
@@ -313,27 +462,79 @@ wxDataViewItem clDataViewListCtrl::RowToItem(size_t row) const
 {
     // Since a clDataViewListCtrl is basically a tree with a single hidden node (the root)
     // A row is simply a child at a given index
+    if(IsVirtualList()) {
+        // In virtual mode, the item simply encodes the row (+1, so row 0 is a valid item)
+        return (row < GetItemCount()) ? wxDataViewItem(wxUIntToPtr(row + 1)) : wxDataViewItem();
+    }
     clRowEntry* root = m_model.GetRoot();
     if(!root) {
         return wxDataViewItem();
     }
-    if(row >= root->GetChildren().size()) {
+    const clRowEntry::Vec_t& children = root->GetChildren();
+    if(row >= children.size()) {
         return wxDataViewItem();
     }
-    return wxDataViewItem(root->GetChildren()[row]);
+    return wxDataViewItem(children[row]);
 }
 
 void clDataViewListCtrl::DeleteItem(size_t row)
 {
+    CHECK_NOT_VIRTUAL_RET();
     wxDataViewItem item = RowToItem(row);
     if(!item.IsOk()) {
         return;
     }
+    m_sortColumn = wxNOT_FOUND; // the sort keys are outdated
     Delete(TREE_ITEM(item));
 }
 
+void clDataViewListCtrl::DeleteRows(size_t first, size_t count, const std::function<void(wxUIntPtr)>& deleterFunc)
+{
+    CHECK_NOT_VIRTUAL_RET();
+    clRowEntry* root = m_model.GetRoot();
+    if(!root || (first >= GetItemCount()) || (count == 0)) {
+        return;
+    }
+    count = std::min(count, GetItemCount() - first);
+    if(deleterFunc) {
+        const clRowEntry::Vec_t& children = root->GetChildren();
+        for(size_t i = first; i < (first + count); ++i) {
+            wxUIntPtr userData = children[i]->GetData();
+            if(userData) {
+                deleterFunc(userData);
+            }
+            children[i]->SetData(0);
+        }
+    }
+    m_sortColumn = wxNOT_FOUND; // the sort keys are outdated
+    root->DeleteChildren(first, count);
+    UpdateScrollBar();
+    Refresh();
+}
+
+void clDataViewListCtrl::InsertRows(size_t row, const std::vector<std::vector<clCellValue>>& rows,
+                                    const std::vector<wxUIntPtr>* data)
+{
+    CHECK_NOT_VIRTUAL_RET();
+    clRowEntry* root = m_model.GetRoot();
+    if(!root || rows.empty()) {
+        return;
+    }
+    clRowEntry::Vec_t newRows;
+    newRows.reserve(rows.size());
+    for(size_t i = 0; i < rows.size(); ++i) {
+        newRows.push_back(DoCreateRow(rows[i], (data && (i < data->size())) ? (*data)[i] : 0));
+    }
+    m_sortColumn = wxNOT_FOUND; // the sort keys are outdated
+    root->InsertChildrenAt(newRows, row);
+    clControlWithItems::DoUpdateHeader(newRows);
+    UpdateScrollBar();
+    Refresh();
+}
+
 void clDataViewListCtrl::SetValue(const wxVariant& value, size_t row, size_t col)
 {
+    CHECK_NOT_VIRTUAL_RET();
     wxDataViewItem item = RowToItem(row);
     if(!item.IsOk()) {
         return;
@@ -344,6 +545,7 @@ void clDataViewListCtrl::SetValue(const wxVariant& value, size_t row, size_t col
 
 void clDataViewListCtrl::DoSetCellValue(clRowEntry* row, size_t col, const wxVariant& value)
 {
+    m_sortColumn = wxNOT_FOUND; // the sort keys are outdated
     wxString variantType = value.GetType();
     if(variantType == "bool") {
         row->SetChecked(value.GetBool(), wxNOT_FOUND, wxString(), col);
@@ -372,17 +574,23 @@ void clDataViewListCtrl::DoSetCellValue(clRowEntry* row, size_t col, const wxVar
         row->SetChoice(true, col);
         row->SetBitmapIndex(choice.GetBitmapIndex(), col);
         row->SetLabel(choice.GetLabel(), col);
+    } else if(variantType == "long") {
+        row->SetValueInt64(value.GetLong(), col);
+    } else if(variantType == "longlong") {
+        row->SetValueInt64(value.GetLongLong().GetValue(), col);
     } else if(variantType == "double") {
-        row->SetLabel(wxString() << value.GetDouble(), col);
+        row->SetValueDouble(value.GetDouble(), col);
     } else if(variantType == "datetime") {
-        row->SetLabel(value.GetDateTime().FormatDate(), col);
+        row->SetValueDateTime(value.GetDateTime(), col);
     }
-    // Call this to update the view + update the header bar
-    clTreeCtrl::SetItemText(wxTreeItemId(row), row->GetLabel(col), col);
+    // Update the header bar + the row. Numeric and time cells are formatted only when needed
+    clControlWithItems::DoUpdateHeader(row);
+    clTreeCtrl::RefreshItem(wxTreeItemId(row));
 }
 
 void clDataViewListCtrl::SetSortFunction(const clSortFunc_t& CompareFunc)
 {
+    CHECK_NOT_VIRTUAL_RET();
     clRowEntry* root = m_model.GetRoot();
     if(!root) {
         return;
@@ -397,7 +605,7 @@ void clDataViewListCtrl::SetSortFunction(const clSortFunc_t& CompareFunc)
 
     // This list ctrl is composed of a hidden root + its children
     // Step 1:
-    clRowEntry::Vec_t& children = root->GetChildren();
+    clRowEntry::Vec_t& children = root->GetChildrenForUpdate();
     for(size_t i = 0; i < children.size(); ++i) {
         clRowEntry* child = children[i];
         child->SetNext(nullptr);
@@ -425,31 +633,133 @@ void clDataViewListCtrl::SetSortFunction(const clSortFunc_t& CompareFunc)
     Refresh();
 }
 
+void clDataViewListCtrl::SortByColumn(size_t col, bool ascending)
+{
+    CHECK_NOT_VIRTUAL_RET();
+    clRowEntry* root = m_model.GetRoot();
+    if(!root) {
+        return;
+    }
+    m_model.SetSortFunction(nullptr);
+
+    if(!DoIsSortKeysValid(col)) {
+        const clRowEntry::Vec_t& children = root->GetChildren();
+        m_sortKeys.clear();
+        m_sortKeys.reserve(children.size());
+        for(clRowEntry* child : children) {
+            SortKey key;
+            key.row = child;
+            key.typed = child->GetCellValue(col).IsTyped();
+            if(!key.typed) {
+                key.text = clTreeCtrlModel::GetSortKey(child->GetLabel(col));
+            }
+            m_sortKeys.push_back(std::move(key));
+        }
+        clParallelStableSort(m_sortKeys.begin(), m_sortKeys.end(), [col](const SortKey& a, const SortKey& b) {
+            return DoCompareSortKeys(a, b, col) < 0;
+        });
+        m_sortColumn = col;
+        m_sortAscending = true;
+    }
+
+    if(ascending != m_sortAscending) {
+        // Reverse the rows, then reverse each run of equal rows so they keep their original order
+        std::reverse(m_sortKeys.begin(), m_sortKeys.end());
+        auto runStart = m_sortKeys.begin();
+        while(runStart != m_sortKeys.end()) {
+            auto runEnd = std::find_if(runStart, m_sortKeys.end(),
+                                       [&](const SortKey& k) { return DoCompareSortKeys(k, *runStart, col) != 0; });
+            std::reverse(runStart, runEnd);
+            runStart = runEnd;
+        }
+        m_sortAscending = ascending;
+    }
+
+    // Re-order the children and re-connect them, starting with the root
+    clRowEntry::Vec_t& children = root->GetChildrenForUpdate();
+    clRowEntry* prev = root;
+    for(size_t i = 0; i < m_sortKeys.size(); ++i) {
+        clRowEntry* child = m_sortKeys[i].row;
+        children[i] = child;
+        prev->SetNext(child);
+        child->SetPrev(prev);
+        prev = child;
+    }
+    prev->SetNext(nullptr);
+    Refresh();
+}
+
+bool clDataViewListCtrl::DoIsSortKeysValid(size_t col) const
+{
+    // The keys can be used as long as no label was modified (m_sortColumn is reset when this happens) and the rows are
+    // the ones we sorted
+    const clRowEntry* root = m_model.GetRoot();
+    if(!root || (m_sortColumn != (int)col)) {
+        return false;
+    }
+    const clRowEntry::Vec_t& children = root->GetChildren();
+    if(children.size() != m_sortKeys.size()) {
+        return false;
+    }
+    for(size_t i = 0; i < children.size(); ++i) {
+        if(children[i] != m_sortKeys[i].row) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int clDataViewListCtrl::DoCompareSortKeys(const SortKey& a, const SortKey& b, size_t col)
+{
+    if(a.typed || b.typed) {
+        return a.row->GetCellValue(col).Compare(b.row->GetCellValue(col));
+    }
+    return a.text.compare(b.text);
+}
+
 int clDataViewListCtrl::ItemToRow(const wxDataViewItem& item) const
 {
+    if(IsVirtualList()) {
+        if(!item.IsOk()) {
+            return wxNOT_FOUND;
+        }
+        size_t row = wxPtrToUInt(item.GetID()) - 1;
+        return (row < GetItemCount()) ? (int)row : wxNOT_FOUND;
+    }
     clRowEntry* pItem = m_model.ToPtr(TREE_ITEM(item));
     if(!pItem) {
         return wxNOT_FOUND;
     }
 
     clRowEntry* root = m_model.GetRoot();
-    if(!root) {
+    if(!root || (pItem->GetParent() != root)) {
         return wxNOT_FOUND;
     }
-
-    const clRowEntry::Vec_t& children = root->GetChildren();
-    for(size_t i = 0; i < children.size(); ++i) {
-        if(children[i] == pItem) {
-            return i;
-        }
-    }
-    return wxNOT_FOUND;
+    // The rows keep their position in the root's children list
+    return pItem->GetIndexInParent();
 }
 
 void clDataViewListCtrl::Select(const wxDataViewItem& item)
 {
+    if(IsVirtualList()) {
+        int row = ItemToRow(item);
+        if(row == wxNOT_FOUND) {
+            return;
+        }
+        if(!HasStyle(wxTR_MULTIPLE)) {
+            m_virtualListSelection.Clear();
+        }
+        m_virtualListSelection.Add(row, row);
+        NotifySelectionChanged();
+        m_virtualCurrentRow = row;
+        m_virtualAnchorRow = row;
+        DoRefreshVirtualSelection();
+        return;
+    }
     if(HasStyle(wxTR_MULTIPLE)) {
+        clRowEntry::Vec_t selectedBefore = DoGetOnScreenSelection();
         m_model.SelectItem(TREE_ITEM(item), true, true, false);
+        DoRefreshSelectionChanges(selectedBefore);
     } else {
         clTreeCtrl::SelectItem(TREE_ITEM(item), true);
     }
@@ -458,39 +768,78 @@ void clDataViewListCtrl::Select(const wxDataViewItem& item)
 wxDataViewItem clDataViewListCtrl::FindNext(const wxDataViewItem& from, const wxString& what, size_t col,
                                             size_t searchFlags)
 {
+    CHECK_NOT_VIRTUAL_RET_VAL(wxDataViewItem());
     return DV_ITEM(clTreeCtrl::FindNext(TREE_ITEM(from), what, col, searchFlags));
 }
 
 wxDataViewItem clDataViewListCtrl::FindPrev(const wxDataViewItem& from, const wxString& what, size_t col,
                                             size_t searchFlags)
 {
+    CHECK_NOT_VIRTUAL_RET_VAL(wxDataViewItem());
     return DV_ITEM(clTreeCtrl::FindPrev(TREE_ITEM(from), what, col, searchFlags));
 }
 
 void clDataViewListCtrl::HighlightText(const wxDataViewItem& item, bool b)
 {
+    CHECK_NOT_VIRTUAL_RET();
     clTreeCtrl::HighlightText(TREE_ITEM(item), b);
 }
 
-void clDataViewListCtrl::ClearHighlight(const wxDataViewItem& item) { clTreeCtrl::ClearHighlight(TREE_ITEM(item)); }
+void clDataViewListCtrl::ClearHighlight(const wxDataViewItem& item)
+{
+    CHECK_NOT_VIRTUAL_RET();
+    clTreeCtrl::ClearHighlight(TREE_ITEM(item));
+}
 
-void clDataViewListCtrl::EnsureVisible(const wxDataViewItem& item) { clTreeCtrl::EnsureVisible(TREE_ITEM(item)); }
+void clDataViewListCtrl::EnsureVisible(const wxDataViewItem& item)
+{
+    if(IsVirtualList()) {
+        int row = ItemToRow(item);
+        if(row == wxNOT_FOUND) {
+            return;
+        }
+        DoVirtualEnsureRowVisible(row);
+        UpdateScrollBar();
+        RefreshAfterScroll();
+        return;
+    }
+    clTreeCtrl::EnsureVisible(TREE_ITEM(item));
+}
+
+void clDataViewListCtrl::RefreshItem(const wxDataViewItem& item)
+{
+    int row = ItemToRow(item);
+    if(row != wxNOT_FOUND) {
+        RefreshRows(row, row);
+    }
+}
+
+void clDataViewListCtrl::RefreshRows(size_t first, size_t last)
+{
+    // In both modes, the tree numbers the visible rows like the list does
+    DoRefreshRows(first, last);
+}
 
 void clDataViewListCtrl::ClearColumns() { GetHeader()->Clear(); }
 
 void clDataViewListCtrl::SetItemChecked(const wxDataViewItem& item, bool checked, size_t col)
 {
+    CHECK_NOT_VIRTUAL_RET();
     clTreeCtrl::Check(TREE_ITEM(item), checked, col);
 }
 
 bool clDataViewListCtrl::IsItemChecked(const wxDataViewItem& item, size_t col) const
 {
+    if(IsVirtualList()) {
+        clCellValue cell;
+        return DoGetVirtualCell(item, col, cell) && cell.GetValueBool();
+    }
     return clTreeCtrl::IsChecked(TREE_ITEM(item), col);
 }
 
 void clDataViewListCtrl::ShowMenuForItem(const wxDataViewItem& item, wxMenu& menu, size_t col)
 {
-    clRowEntry* row = m_model.ToPtr(TREE_ITEM(item));
+    clRowEntry* row = IsVirtualList() ? DoGetVirtualSlot(item) : m_model.ToPtr(TREE_ITEM(item));
     if(!row) {
         return;
     }
@@ -501,7 +850,7 @@ void clDataViewListCtrl::ShowMenuForItem(const wxDataViewItem& item, wxMenu& men
 
 void clDataViewListCtrl::ShowStringSelectionMenu(const wxDataViewItem& item, const wxArrayString& choices, size_t col)
 {
-    clRowEntry* row = m_model.ToPtr(TREE_ITEM(item));
+    clRowEntry* row = IsVirtualList() ? DoGetVirtualSlot(item) : m_model.ToPtr(TREE_ITEM(item));
     if(!row) {
         return;
     }
@@ -564,6 +913,13 @@ void clDataViewListCtrl::SelectRow(size_t row)
 
 void clDataViewListCtrl::UnselectRow(size_t row)
 {
+    if(IsVirtualList()) {
+        if(m_virtualListSelection.Remove(row)) {
+            NotifySelectionChanged();
+            RefreshRows(row, row);
+        }
+        return;
+    }
     wxDataViewItem item = RowToItem(row);
     if(!item.IsOk()) {
         return;
@@ -573,6 +929,9 @@ void clDataViewListCtrl::UnselectRow(size_t row)
 
 bool clDataViewListCtrl::IsRowSelected(size_t row) const
 {
+    if(IsVirtualList()) {
+        return m_virtualListSelection.Contains(row);
+    }
     wxDataViewItem item = RowToItem(row);
     if(!item.IsOk()) {
         return false;
@@ -599,6 +958,12 @@ void clDataViewListCtrl::SetFirstVisibleRow(size_t row)
         return;
     }
 
+    if(IsVirtualList()) {
+        m_virtualFirstRow = wxMin(row, DoGetVirtualMaxFirstRow(GetItemCount()));
+        Refresh();
+        return;
+    }
+
     auto row_ptr = m_model.ToPtr(TREE_ITEM(item));
     if(!row_ptr) {
         return;
@@ -616,3 +981,349 @@ void clDataViewListCtrl::CenterRow(size_t row)
     size_t first_row = row - max_rows + (max_rows / 2);
     SetFirstVisibleRow(first_row);
 }
+
+void clDataViewListCtrl::UnselectAll()
+{
+    if(IsVirtualList()) {
+        if(!m_virtualListSelection.IsEmpty()) {
+            m_virtualListSelection.Clear();
+            NotifySelectionChanged();
+        }
+        Refresh();
+        return;
+    }
+    clTreeCtrl::UnselectAll();
+}
+
+void clDataViewListCtrl::SelectAll()
+{
+    if(IsVirtualList()) {
+        if(!HasStyle(wxTR_MULTIPLE)) {
+            return;
+        }
+        if(GetItemCount() == 0) {
+            return;
+        }
+        // A single range, no matter how many rows
+        m_virtualListSelection.Clear();
+        m_virtualListSelection.Add(0, GetItemCount() - 1);
+        NotifySelectionChanged();
+        Refresh();
+        return;
+    }
+    clTreeCtrl::SelectAll();
+}
+
+void clDataViewListCtrl::SetVirtualListModel(clDataViewListVirtualModel* model)
+{
+    // Switching modes removes the rows of the current mode
+    DeleteAllItems();
+    m_virtualListModel = model;
+    UpdateScrollBar();
+    Refresh();
+}
+
+void clDataViewListCtrl::RefreshVirtualRows()
+{
+    if(!IsVirtualList()) {
+        return;
+    }
+
+    // Forget about rows that no longer exist
+    size_t count = GetItemCount();
+    size_t selected = m_virtualListSelection.GetRowsCount();
+    m_virtualListSelection.Truncate(count);
+    if(m_virtualListSelection.GetRowsCount() != selected) {
+        NotifySelectionChanged();
+    }
+    if(m_virtualCurrentRow != wxNOT_FOUND && (size_t)m_virtualCurrentRow >= count) {
+        m_virtualCurrentRow = wxNOT_FOUND;
+    }
+    if(m_virtualAnchorRow != wxNOT_FOUND && (size_t)m_virtualAnchorRow >= count) {
+        m_virtualAnchorRow = wxNOT_FOUND;
+    }
+    m_virtualFirstRow = wxMin(m_virtualFirstRow, DoGetVirtualMaxFirstRow(GetItemCount()));
+    UpdateScrollBar();
+    Refresh();
+}
+
+int clDataViewListCtrl::GetFirstItemPosition() const
+{
+    if(IsVirtualList()) {
+        return m_virtualFirstRow;
+    }
+    return clTreeCtrl::GetFirstItemPosition();
+}
+
+bool clDataViewListCtrl::DoPaintRows(wxDC& dc)
+{
+    if(!IsVirtualList()) {
+        return clTreeCtrl::DoPaintRows(dc);
+    }
+
+    // The row count might have changed since the last paint
+    size_t count = GetItemCount();
+    m_virtualFirstRow = wxMin(m_virtualFirstRow, DoGetVirtualMaxFirstRow(count));
+    size_t maxItems = wxMax(GetNumLineCanFitOnScreen(), 0);
+    size_t visibleRows = (m_virtualFirstRow < count) ? wxMin(maxItems, count - m_virtualFirstRow) : 0;
+
+    // The visible rows are drawn using a fixed set of "slots" which are bound to the visible rows on every paint, so
+    // the memory used does not depend on the number of rows
+    clRowEntry::Vec_t items;
+    items.reserve(visibleRows);
+    DoGetVirtualSlots(visibleRows, items);
+
+    size_t columnsCount = GetHeader()->empty() ? 1 : GetHeader()->size();
+    for(size_t i = 0; i < items.size(); ++i) {
+        size_t row = m_virtualFirstRow + i;
+        clRowEntry* slot = items[i];
+        slot->SetListItem(true);
+        slot->SetData(row);
+        slot->SetSelected(m_virtualListSelection.Contains(row));
+        for(size_t col = 0; col < columnsCount; ++col) {
+            clCellValue cell("", -1, -1);
+            m_virtualListModel->GetCellValue(row, col, cell);
+            slot->SetCellValue(cell, col);
+        }
+        // Auto-resize columns grow to fit the rows seen so far
+        clControlWithItems::DoUpdateHeader(slot);
+    }
+    m_model.SetFirstItemOnScreen(items.empty() ? nullptr : items[0]);
+    DoRenderRows(dc, items, m_virtualFirstRow);
+    return true;
+}
+
+int clDataViewListCtrl::DoVirtualHitTest(const wxPoint& pt, int& flags, int& column) const
+{
+    wxTreeItemId where = HitTest(pt, flags, column);
+    if(!where.IsOk()) {
+        return wxNOT_FOUND;
+    }
+    // the slot knows which row it displays
+    return m_model.ToPtr(where)->GetData();
+}
+
+clRowEntry* clDataViewListCtrl::DoGetVirtualSlot(const wxDataViewItem& item) const
+{
+    int row = ItemToRow(item);
+    if(row == wxNOT_FOUND) {
+        return nullptr;
+    }
+    for(clRowEntry* slot : m_model.GetOnScreenItems()) {
+        if(slot->GetData() == (wxUIntPtr)row) {
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+bool clDataViewListCtrl::DoGetVirtualCell(const wxDataViewItem& item, size_t col, clCellValue& cell) const
+{
+    int row = ItemToRow(item);
+    if(row == wxNOT_FOUND) {
+        return false;
+    }
+    cell = clCellValue("", -1, -1);
+    m_virtualListModel->GetCellValue(row, col, cell);
+    return true;
+}
+
+void clDataViewListCtrl::DoVirtualSelectRow(size_t row, bool ctrlDown, bool shiftDown)
+{
+    bool multiple = HasStyle(wxTR_MULTIPLE);
+    if(multiple && ctrlDown) {
+        // Toggle the selection
+        if(!m_virtualListSelection.Remove(row)) {
+            m_virtualListSelection.Add(row, row);
+        }
+        m_virtualAnchorRow = row;
+    } else if(multiple && shiftDown && m_virtualAnchorRow != wxNOT_FOUND) {
+        // Range selection
+        m_virtualListSelection.Add(wxMin((size_t)m_virtualAnchorRow, row), wxMax((size_t)m_virtualAnchorRow, row));
+    } else {
+        // The default, single selection
+        if(m_virtualListSelection.GetRowsCount() == 1 && m_virtualListSelection.GetFirstRow() == row) {
+            m_virtualCurrentRow = row;
+            return;
+        }
+        m_virtualListSelection.Clear();
+        m_virtualListSelection.Add(row, row);
+        m_virtualAnchorRow = row;
+    }
+    m_virtualCurrentRow = row;
+    NotifySelectionChanged();
+    SendVirtualListEvent(wxEVT_DATAVIEW_SELECTION_CHANGED, row);
+}
+
+void clDataViewListCtrl::DoRefreshVirtualSelection()
+{
+    // The slots keep the selection state they were drawn with
+    for(clRowEntry* slot : m_model.GetOnScreenItems()) {
+        size_t row = slot->GetData();
+        if(slot->IsSelected() != m_virtualListSelection.Contains(row)) {
+            RefreshRows(row, row);
+        }
+    }
+}
+
+bool clDataViewListCtrl::SendVirtualListEvent(const wxEventType& type, int row, int col)
+{
+#if wxCHECK_VERSION(3, 1, 0)
+    wxDataViewEvent e(type, &m_dummy, RowToItem(row));
+#else
+    wxDataViewEvent e(type);
+    e.SetItem(RowToItem(row));
+#endif
+    e.SetEventObject(this);
+    e.SetColumn(col);
+    return GetEventHandler()->ProcessEvent(e);
+}
+
+void clDataViewListCtrl::OnVirtualLeftDown(wxMouseEvent& event)
+{
+    if(!IsVirtualList()) {
+        event.Skip();
+        return;
+    }
+
+    // The slots are never selected by the tree, selection is kept per row
+    SetFocus();
+    int flags = 0;
+    int column = wxNOT_FOUND;
+    int row = DoVirtualHitTest(event.GetPosition(), flags, column);
+    if(row == wxNOT_FOUND) {
+        return;
+    }
+
+    if(flags & wxTREE_HITTEST_ONITEMSTATEICON) {
+        // The model owns the value, let it toggle it
+        SendVirtualListEvent(wxEVT_DATAVIEW_ITEM_VALUE_CHANGED, row, column);
+        RefreshRows(row, row);
+    }
+    DoVirtualSelectRow(row, event.ControlDown(), event.ShiftDown());
+    DoRefreshVirtualSelection();
+    size_t firstRow = m_virtualFirstRow;
+    DoVirtualEnsureRowVisible(row);
+    if((flags & wxTREE_HITTEST_ONDROPDOWNARROW) && (m_virtualListSelection.GetRowsCount() == 1)) {
+        SendVirtualListEvent(wxEVT_DATAVIEW_CHOICE_BUTTON, row, column);
+    }
+    if(m_virtualFirstRow != firstRow) {
+        UpdateScrollBar();
+        RefreshAfterScroll();
+    }
+}
+
+void clDataViewListCtrl::OnVirtualLeftDClick(wxMouseEvent& event)
+{
+    if(!IsVirtualList()) {
+        event.Skip();
+        return;
+    }
+
+    int flags = 0;
+    int column = wxNOT_FOUND;
+    int row = DoVirtualHitTest(event.GetPosition(), flags, column);
+    if(row == wxNOT_FOUND) {
+        return;
+    }
+    DoVirtualSelectRow(row, false, false);
+    DoRefreshVirtualSelection();
+    SendVirtualListEvent(wxEVT_DATAVIEW_ITEM_ACTIVATED, row, column);
+}
+
+void clDataViewListCtrl::OnVirtualContextMenu(wxContextMenuEvent& event)
+{
+    if(!IsVirtualList()) {
+        event.Skip();
+        return;
+    }
+
+    int flags = 0;
+    int column = wxNOT_FOUND;
+    int row = DoVirtualHitTest(ScreenToClient(::wxGetMousePosition()), flags, column);
+    if(row == wxNOT_FOUND) {
+        event.Skip();
+        return;
+    }
+    if(!IsRowSelected(row)) {
+        DoVirtualSelectRow(row, false, false);
+        DoRefreshVirtualSelection();
+    }
+    SendVirtualListEvent(wxEVT_DATAVIEW_ITEM_CONTEXT_MENU, row, column);
+}
+
+bool clDataViewListCtrl::DoKeyDown(const wxKeyEvent& event)
+{
+    if(!IsVirtualList()) {
+        return clTreeCtrl::DoKeyDown(event);
+    }
+
+    // Let the user chance to process this first
+    wxTreeEvent evt(wxEVT_TREE_KEY_DOWN);
+    evt.SetEventObject(this);
+    evt.SetKeyEvent(event);
+    if(GetEventHandler()->ProcessEvent(evt)) {
+        return true;
+    }
+
+    if((event.GetKeyCode() == WXK_RETURN || event.GetKeyCode() == WXK_NUMPAD_ENTER) &&
+       (m_virtualCurrentRow != wxNOT_FOUND)) {
+        SendVirtualListEvent(wxEVT_DATAVIEW_ITEM_ACTIVATED, m_virtualCurrentRow);
+        return true;
+    }
+    // Let clScrolledPanel handle the navigation keys
+    return false;
+}
+
+void clDataViewListCtrl::DoMouseScroll(const wxMouseEvent& event)
+{
+    if(!IsVirtualList()) {
+        clTreeCtrl::DoMouseScroll(event);
+        return;
+    }
+    clControlWithItems::DoMouseScroll(event);
+    UpdateScrollBar();
+}
+
+void clDataViewListCtrl::ScrollToRow(int firstLine)
+{
+    if(!IsVirtualList()) {
+        clTreeCtrl::ScrollToRow(firstLine);
+        return;
+    }
+    m_virtualFirstRow = wxMin((size_t)wxMax(firstLine, 0), DoGetVirtualMaxFirstRow(GetItemCount()));
+#if CL_USE_NATIVE_SCROLLBAR
+    UpdateScrollBar();
+#endif
+    RefreshAfterScroll();
+}
+
+void clDataViewListCtrl::ScrollRows(int steps, wxDirection direction)
+{
+    if(!IsVirtualList()) {
+        clTreeCtrl::ScrollRows(steps, direction);
+        return;
+    }
+
+    size_t count = GetItemCount();
+    if(count == 0) {
+        return;
+    }
+
+    size_t row = 0;
+    if(steps == 0) {
+        // Top or Bottom
+        row = (direction == wxUP) ? 0 : (count - 1);
+    } else {
+        size_t current = (m_virtualCurrentRow == wxNOT_FOUND) ? m_virtualFirstRow : m_virtualCurrentRow;
+        if(direction == wxUP) {
+            row = (current > (size_t)steps) ? (current - steps) : 0;
+        } else {
+            row = wxMin(current + steps, count - 1);
+        }
+    }
+    DoVirtualSelectRow(row, false, ::wxGetKeyState(WXK_SHIFT));
+    DoVirtualEnsureRowVisible(row);
+    Refresh();
+    UpdateScrollBar();
+}
@@ -17,6 +17,26 @@
 #define wxDV_SEARCH_INCLUDE_CURRENT_ITEM wxTR_SEARCH_INCLUDE_CURRENT_ITEM
 #define wxDV_SEARCH_DEFAULT wxTR_SEARCH_DEFAULT
 
+/**
+ * @brief rows provider for clDataViewListCtrl in virtual mode. The control does not store the rows, instead, it asks
+ * the provider for the cells of the rows that are currently visible
+ */
+class WXDLLIMPEXP_SDK clDataViewListVirtualModel
+{
+public:
+    clDataViewListVirtualModel() {}
+    virtual ~clDataViewListVirtualModel() {}
+
+    /**
+     * @brief return the number of rows
+     */
+    virtual size_t GetRowCount() const = 0;
+    /**
+     * @brief fill 'cell' (text, bitmap, colours, font) for a given row/column. 'cell' is passed as an empty text cell
+     */
+    virtual void GetCellValue(size_t row, size_t col, clCellValue& cell) const = 0;
+};
+
 /**
  * @brief a thin wrapper around clTreeCtrl which provides basic compatiblity API (such as adding columns)
  * This is mainly for code generators like wxCrafter
@@ -27,10 +47,49 @@ class WXDLLIMPEXP_SDK clDataViewListCtrl : public clTreeCtrl
 
     static std::unordered_map<int, int> m_stylesMap;
 
+    // Virtual mode
+    clDataViewListVirtualModel* m_virtualListModel = nullptr;
+    int m_virtualCurrentRow = wxNOT_FOUND;
+    int m_virtualAnchorRow = wxNOT_FOUND;
+    clRowRanges m_virtualListSelection;
+
+    // Sort by column: the sort keys, in the rows order, are kept so changing the direction does not extract them again
+    struct SortKey {
+        wxString text;          // the lowered label of a text cell
+        clRowEntry* row = nullptr;
+        bool typed = false;     // numeric and time cells are compared by value, see clCellValue::Compare
+    };
+    std::vector<SortKey> m_sortKeys;
+    int m_sortColumn = wxNOT_FOUND;
+    bool m_sortAscending = true;
+
 protected:
     void OnConvertEvent(wxTreeEvent& event);
     bool SendDataViewEvent(const wxEventType& type, wxTreeEvent& treeEvent, const wxString& text = "");
     void DoSetCellValue(clRowEntry* row, size_t col, const wxVariant& value);
+    bool DoIsSortKeysValid(size_t col) const;
+    static int DoCompareSortKeys(const SortKey& a, const SortKey& b, size_t col);
+    clRowEntry* DoCreateRow(const std::vector<clCellValue>& cells, wxUIntPtr data);
+
+    // Virtual mode
+    void OnVirtualLeftDown(wxMouseEvent& event);
+    void OnVirtualLeftDClick(wxMouseEvent& event);
+    void OnVirtualContextMenu(wxContextMenuEvent& event);
+    bool DoPaintRows(wxDC& dc) override;
+    bool DoKeyDown(const wxKeyEvent& event) override;
+    void DoMouseScroll(const wxMouseEvent& event) override;
+    void ScrollRows(int steps, wxDirection direction) override;
+    void ScrollToRow(int firstLine) override;
+    int DoVirtualHitTest(const wxPoint& pt, int& flags, int& column) const;
+    void DoVirtualSelectRow(size_t row, bool ctrlDown, bool shiftDown);
+    /**
+     * @brief refresh the on screen rows which selection state differs from the one they were drawn with
+     */
+    void DoRefreshVirtualSelection();
+    bool SendVirtualListEvent(const wxEventType& type, int row, int col = 0);
+    bool DoGetVirtualCell(const wxDataViewItem& item, size_t col, clCellValue& cell) const;
+    clRowEntry* DoGetVirtualSlot(const wxDataViewItem& item) const;
+    void DoGetBatchSelections(wxArrayTreeItemIds& items) const override;
 
 public:
     clDataViewListCtrl(wxWindow* parent, wxWindowID id = wxID_ANY, const wxPoint& pos = wxDefaultPosition,
@@ -39,6 +98,25 @@ public:
 
     void ScrollToBottom();
 
+    /**
+     * @brief switch the control into virtual mode. In virtual mode the rows are not stored by the control. Only the
+     * visible rows are requested from 'model'. The model is not owned by the control. Pass nullptr to switch back into
+     * the normal mode. Any existing rows are deleted.
+     * Note that the item based setters (e.g. SetItemText) have no effect in virtual mode, the items returned by the
+     * control simply encode the row number. This is unrelated to the tree virtual mode (clTreeCtrl::SetVirtualModel),
+     * which must not be used with a list
+     */
+    void SetVirtualListModel(clDataViewListVirtualModel* model);
+    clDataViewListVirtualModel* GetVirtualListModel() const { return m_virtualListModel; }
+    bool IsVirtualList() const { return m_virtualListModel != nullptr; }
+
+    /**
+     * @brief call this after the number of rows or the content of the virtual model has changed
+     */
+    void RefreshVirtualRows();
+
+    int GetFirstItemPosition() const override;
+
     /**
      * @brief make row the first visible row in the view
      */
@@ -91,6 +169,16 @@ public:
      */
     void EnsureVisible(const wxDataViewItem& item);
 
+    /**
+     * @brief repaint the row of 'item' only. Does nothing if the row is not on screen
+     */
+    void RefreshItem(const wxDataViewItem& item);
+
+    /**
+     * @brief repaint the rows 'first' to 'last' (inclusive) only
+     */
+    void RefreshRows(size_t first, size_t last);
+
     /**
      * @brief appends an item to the end of the list
      */
@@ -104,6 +192,15 @@ public:
 
     void AppendItem(const wxVector<wxVariant>& values, wxUIntPtr data = 0);
 
+    /**
+     * @brief append a row, the cells are stored as they are (no wxVariant conversion)
+     */
+    void AppendItem(const std::vector<clCellValue>& cells, wxUIntPtr data = 0);
+    /**
+     * @brief append many rows at once. 'data' (when provided) holds the client data of each row
+     */
+    void AppendItems(const std::vector<std::vector<clCellValue>>& rows, const std::vector<wxUIntPtr>* data = nullptr);
+
     wxDataViewColumn* AppendIconTextColumn(const wxString& label, wxDataViewCellMode mode = wxDATAVIEW_CELL_INERT,
                                            int width = -1, wxAlignment align = wxALIGN_LEFT,
                                            int flags = wxDATAVIEW_COL_RESIZABLE);
@@ -116,9 +213,14 @@ public:
                                        int width = -1, wxAlignment align = wxALIGN_LEFT,
                                        int flags = wxDATAVIEW_COL_RESIZABLE);
 
-    wxDataViewItem GetSelection() const { return wxDataViewItem(clTreeCtrl::GetSelection().GetID()); }
-    wxDataViewItem GetCurrentItem() const { return wxDataViewItem(GetFocusedItem().GetID()); }
+    wxDataViewItem GetSelection() const;
+    wxDataViewItem GetCurrentItem() const;
     void Select(const wxDataViewItem& item);
+    void UnselectAll();
+    /**
+     * @brief select all the rows (multiple selection only)
+     */
+    void SelectAll();
     int GetSelections(wxDataViewItemArray& sel) const;
     int GetSelectedItemsCount() const;
     /**
@@ -157,7 +259,8 @@ public:
     wxDataViewItem RowToItem(size_t row) const;
 
     /**
-     * @brief return row number from item. This function is executed in O(N)
+     * @brief return row number from item. The rows positions are cached, so this function is executed in O(1) (the
+     * first call after rows were inserted or deleted updates the positions in a single pass)
      */
     int ItemToRow(const wxDataViewItem& item) const;
 
@@ -165,6 +268,19 @@ public:
      * @brief Delete the row at position row.
      */
     void DeleteItem(size_t row);
+
+    /**
+     * @brief delete 'count' rows starting at row 'first' in a single pass. If a "deleterFunc" is provided, it will be
+     * called per item data
+     */
+    void DeleteRows(size_t first, size_t count, const std::function<void(wxUIntPtr)>& deleterFunc = nullptr);
+
+    /**
+     * @brief insert rows before row 'row' (or at the end, if 'row' is out of range) in a single pass. The rows are
+     * placed as requested, the sort function is not used. 'data' (when provided) holds the client data of each row
+     */
+    void InsertRows(size_t row, const std::vector<std::vector<clCellValue>>& rows,
+                    const std::vector<wxUIntPtr>* data = nullptr);
     /**
      * @brief Sets the value of a given row/col (i.e. cell)
      */
@@ -175,6 +291,13 @@ public:
      */
     void SetSortFunction(const clSortFunc_t& CompareFunc);
 
+    /**
+     * @brief sort the rows by column 'col': texts case insensitive, numbers and times by value. The sort keys are
+     * extracted once and sorted using all the cores, equal rows keep their order. Sorting again by the same column in
+     * the other direction reuses the keys. This disables the sort function (see SetSortFunction)
+     */
+    void SortByColumn(size_t col, bool ascending = true);
+
     /**
      * @brief remove all columns from the control
      */
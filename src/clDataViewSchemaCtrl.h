@@ -0,0 +1,210 @@
+#ifndef CLDATAVIEWSCHEMACTRL_H
+#define CLDATAVIEWSCHEMACTRL_H
+
+#include "clDataViewListCtrl.h"
+#include "clParallelSort.h"
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Convert a native value into a cell. One overload per supported column type, picked at compile time
+inline void clSchemaSetCell(const wxString& value, clCellValue& cell) { cell.SetValue(value); }
+inline void clSchemaSetCell(bool value, clCellValue& cell)
+{
+    cell.SetType(clCellValue::kTypeBool);
+    cell.SetValue(value);
+}
+inline void clSchemaSetCell(int value, clCellValue& cell) { cell.SetValueInt64(value); }
+inline void clSchemaSetCell(long value, clCellValue& cell) { cell.SetValueInt64(value); }
+inline void clSchemaSetCell(long long value, clCellValue& cell) { cell.SetValueInt64(value); }
+inline void clSchemaSetCell(double value, clCellValue& cell) { cell.SetValueDouble(value); }
+inline void clSchemaSetCell(const wxDateTime& value, clCellValue& cell) { cell.SetValueDateTime(value); }
+
+// Stable sort the rows by their I-th value
+template <size_t I, typename Row, typename T>
+void clSchemaSortRows(std::vector<Row>& rows, bool ascending, const T*)
+{
+    if(ascending) {
+        clParallelStableSort(rows.begin(), rows.end(),
+                             [](const Row& a, const Row& b) { return std::get<I>(a) < std::get<I>(b); });
+    } else {
+        clParallelStableSort(rows.begin(), rows.end(),
+                             [](const Row& a, const Row& b) { return std::get<I>(b) < std::get<I>(a); });
+    }
+}
+
+// Texts are sorted case insensitive, like clDataViewListCtrl::SortByColumn does: lower the texts once (and not once
+// per comparison), sort the keys and move the rows in place
+template <size_t I, typename Row>
+void clSchemaSortRows(std::vector<Row>& rows, bool ascending, const wxString*)
+{
+    typedef std::pair<wxString, size_t> Key_t;
+    std::vector<Key_t> keys;
+    keys.reserve(rows.size());
+    for(size_t i = 0; i < rows.size(); ++i) {
+        keys.push_back({ clTreeCtrlModel::GetSortKey(std::get<I>(rows[i])), i });
+    }
+    if(ascending) {
+        clParallelStableSort(keys.begin(), keys.end(),
+                             [](const Key_t& a, const Key_t& b) { return a.first < b.first; });
+    } else {
+        clParallelStableSort(keys.begin(), keys.end(),
+                             [](const Key_t& a, const Key_t& b) { return b.first < a.first; });
+    }
+    std::vector<Row> sorted;
+    sorted.reserve(rows.size());
+    for(const Key_t& key : keys) {
+        sorted.push_back(std::move(rows[key.second]));
+    }
+    rows.swap(sorted);
+}
+
+/**
+ * @brief maps a column index known at runtime to the matching tuple element. The recursion is unrolled by the
+ * compiler, so there is no type check at runtime, only a switch on the column index
+ */
+template <size_t I, size_t N> struct clSchemaColumn {
+    template <typename Row> static void GetCell(const Row& row, size_t col, clCellValue& cell)
+    {
+        if(col == I) {
+            clSchemaSetCell(std::get<I>(row), cell);
+        } else {
+            clSchemaColumn<I + 1, N>::GetCell(row, col, cell);
+        }
+    }
+
+    template <typename Row> static void Sort(std::vector<Row>& rows, size_t col, bool ascending)
+    {
+        if(col == I) {
+            typedef typename std::tuple_element<I, Row>::type Value_t;
+            clSchemaSortRows<I>(rows, ascending, (const Value_t*)nullptr);
+        } else {
+            clSchemaColumn<I + 1, N>::Sort(rows, col, ascending);
+        }
+    }
+};
+
+template <size_t N> struct clSchemaColumn<N, N> {
+    template <typename Row> static void GetCell(const Row& row, size_t col, clCellValue& cell)
+    {
+        wxUnusedVar(row);
+        wxUnusedVar(col);
+        wxUnusedVar(cell);
+    }
+    template <typename Row> static void Sort(std::vector<Row>& rows, size_t col, bool ascending)
+    {
+        wxUnusedVar(rows);
+        wxUnusedVar(col);
+        wxUnusedVar(ascending);
+    }
+};
+
+/**
+ * @brief rows storage for tables whose columns are known at build time. A row is a std::tuple<Types...> stored by
+ * value, so adding a row does not allocate cells and reading a cell does not check its type. The supported column
+ * types are: wxString, bool, int, long, long long, double and wxDateTime
+ */
+template <typename... Types> class clDataViewSchemaModel : public clDataViewListVirtualModel
+{
+public:
+    typedef std::tuple<Types...> Row_t;
+    static const size_t COLUMNS_COUNT = sizeof...(Types);
+
+protected:
+    std::vector<Row_t> m_rows;
+
+public:
+    clDataViewSchemaModel() {}
+    virtual ~clDataViewSchemaModel() {}
+
+    size_t GetRowCount() const override { return m_rows.size(); }
+    void GetCellValue(size_t row, size_t col, clCellValue& cell) const override
+    {
+        if(row < m_rows.size()) {
+            clSchemaColumn<0, COLUMNS_COUNT>::GetCell(m_rows[row], col, cell);
+        }
+    }
+
+    void Append(const Row_t& row) { m_rows.push_back(row); }
+    void Append(Row_t&& row) { m_rows.push_back(std::move(row)); }
+    void Reserve(size_t count) { m_rows.reserve(count); }
+    void Clear() { m_rows.clear(); }
+
+    const Row_t& GetRow(size_t row) const { return m_rows[row]; }
+    Row_t& GetRow(size_t row) { return m_rows[row]; }
+    const std::vector<Row_t>& GetRows() const { return m_rows; }
+    std::vector<Row_t>& GetRows() { return m_rows; }
+
+    /**
+     * @brief stable sort the rows by column 'col' using all the cores
+     */
+    void Sort(size_t col, bool ascending = true) { clSchemaColumn<0, COLUMNS_COUNT>::Sort(m_rows, col, ascending); }
+};
+
+/**
+ * @brief a clDataViewListCtrl displaying a clDataViewSchemaModel, e.g.:
+ * clDataViewSchemaCtrl<wxString, long long, double> ctrl(parent);
+ * ctrl.AppendRow(std::make_tuple(wxString("foo"), 1LL, 2.5));
+ * The control runs in virtual mode, rows are accessed by their index (see clDataViewListCtrl::SetVirtualListModel).
+ * Columns should be added once per schema type (AppendTextColumn)
+ */
+template <typename... Types> class clDataViewSchemaCtrl : public clDataViewListCtrl
+{
+public:
+    typedef clDataViewSchemaModel<Types...> Model_t;
+    typedef typename Model_t::Row_t Row_t;
+
+protected:
+    Model_t m_rows;
+
+public:
+    clDataViewSchemaCtrl(wxWindow* parent, wxWindowID id = wxID_ANY, const wxPoint& pos = wxDefaultPosition,
+                         const wxSize& size = wxDefaultSize, long style = 0)
+        : clDataViewListCtrl(parent, id, pos, size, style)
+    {
+        SetVirtualListModel(&m_rows);
+    }
+    virtual ~clDataViewSchemaCtrl() {}
+
+    /**
+     * @brief direct access to the rows. Call RefreshVirtualRows() after modifying them
+     */
+    Model_t& GetRows() { return m_rows; }
+    const Model_t& GetRows() const { return m_rows; }
+
+    void AppendRow(const Row_t& row)
+    {
+        m_rows.Append(row);
+        RefreshVirtualRows();
+    }
+
+    void AppendRows(std::vector<Row_t>&& rows)
+    {
+        if(m_rows.GetRowCount() == 0) {
+            m_rows.GetRows().swap(rows);
+        } else {
+            std::vector<Row_t>& all = m_rows.GetRows();
+            all.insert(all.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+        }
+        RefreshVirtualRows();
+    }
+
+    void DeleteAllRows()
+    {
+        m_rows.Clear();
+        UnselectAll();
+        RefreshVirtualRows();
+    }
+
+    /**
+     * @brief sort the rows by column 'col'. The selection (which is made of row indexes) is cleared
+     */
+    void SortByColumn(size_t col, bool ascending = true)
+    {
+        m_rows.Sort(col, ascending);
+        UnselectAll();
+        RefreshVirtualRows();
+    }
+};
+
+#endif // CLDATAVIEWSCHEMACTRL_H
@@ -1,6 +1,7 @@
 #include "clControlWithItems.h"
 #include "clHeaderBar.h"
 #include "clScrolledPanel.h"
+#include <algorithm>
 #include <wx/cursor.h>
 #include <wx/dcbuffer.h>
 #include <wx/dcgraph.h>
@@ -191,6 +192,21 @@ int clHeaderBar::HitBorder(int x) const // Returns the column whose *right*-hand
     return wxNOT_FOUND;
 }
 
+int clHeaderBar::HitColumn(int x) const
+{
+    if(m_columns.empty()) {
+        return wxNOT_FOUND;
+    }
+    // The first column which starts after x
+    clHeaderItem::Vect_t::const_iterator iter =
+        std::upper_bound(m_columns.begin(), m_columns.end(), x,
+                         [](int pos, const clHeaderItem& column) { return pos < column.GetRect().GetX(); });
+    if(iter == m_columns.begin()) {
+        return 0;
+    }
+    return (iter - m_columns.begin()) - 1;
+}
+
 size_t clHeaderBar::GetWidth() const
 {
     size_t w = 0;
@@ -105,6 +105,12 @@ public:
     void Render(wxDC& dc, const clColours& colours);
     size_t GetWidth() const;
 
+    /**
+     * @brief return the column at 'x' (a position in the columns coordinates, i.e. the horizontal scroll is included).
+     * Positions past the last column belong to the last column. Runs in O(log(columns))
+     */
+    int HitColumn(int x) const;
+
     /**
      * @brief are we dragging a column?
      */
@@ -0,0 +1,80 @@
+#include "clMemoryPool.h"
+
+clMemoryPool::clMemoryPool() {}
+
+clMemoryPool::~clMemoryPool() { Release(); }
+
+void* clMemoryPool::Allocate(size_t size)
+{
+    ++m_stats.allocations;
+    if(size > kMaxBlockSize) {
+        ++m_stats.largeAllocations;
+        return ::operator new(size);
+    }
+
+    // Recycle a block of the same size class, if we have one
+    size_t sizeClass = GetSizeClass(size);
+    if(sizeClass < m_freeLists.size() && m_freeLists[sizeClass]) {
+        FreeBlock* block = m_freeLists[sizeClass];
+        m_freeLists[sizeClass] = block->next;
+        return block;
+    }
+
+    // Carve a new block from the current slab. The remainder of a full slab is simply abandoned
+    size_t blockSize = (sizeClass + 1) * kGranularity;
+    if(m_cursor == nullptr || (size_t)(m_end - m_cursor) < blockSize) {
+        char* slab = static_cast<char*>(::operator new(kSlabSize));
+        m_slabs.push_back(slab);
+        m_cursor = slab;
+        m_end = slab + kSlabSize;
+        ++m_stats.slabs;
+        m_stats.bytesReserved += kSlabSize;
+    }
+    void* block = m_cursor;
+    m_cursor += blockSize;
+    return block;
+}
+
+void clMemoryPool::Free(void* ptr, size_t size)
+{
+    if(!ptr) {
+        return;
+    }
+    ++m_stats.deallocations;
+    if(size > kMaxBlockSize) {
+        ::operator delete(ptr);
+        return;
+    }
+    if(m_releasing) {
+        // The slab is about to be released
+        return;
+    }
+
+    size_t sizeClass = GetSizeClass(size);
+    if(sizeClass >= m_freeLists.size()) {
+        m_freeLists.resize(sizeClass + 1, nullptr);
+    }
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = m_freeLists[sizeClass];
+    m_freeLists[sizeClass] = block;
+}
+
+void clMemoryPool::Release(const std::function<void()>& destroyFunc)
+{
+    if(destroyFunc) {
+        m_releasing = true;
+        destroyFunc();
+        m_releasing = false;
+    }
+
+    for(char* slab : m_slabs) {
+        ::operator delete(slab);
+    }
+    m_slabs.clear();
+    m_freeLists.clear();
+    m_cursor = nullptr;
+    m_end = nullptr;
+    m_stats.slabs = 0;
+    m_stats.bytesReserved = 0;
+    ++m_stats.releases;
+}
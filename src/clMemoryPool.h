@@ -0,0 +1,114 @@
+#ifndef CLMEMORYPOOL_H
+#define CLMEMORYPOOL_H
+
+#include "codelite_exports.h"
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief a slab allocator with fixed size classes. Small blocks are carved out of large slabs and recycled through
+ * per size class free lists. Blocks larger than kMaxBlockSize are passed to the global allocator
+ */
+class WXDLLIMPEXP_SDK clMemoryPool
+{
+public:
+    struct Stats {
+        size_t allocations = 0;         // calls to Allocate()
+        size_t deallocations = 0;       // calls to Free()
+        size_t largeAllocations = 0;    // allocations that were too big for the pool
+        size_t slabs = 0;               // number of slabs currently held by the pool
+        size_t bytesReserved = 0;       // memory currently held by the slabs
+        size_t releases = 0;            // calls to Release()
+    };
+
+    enum {
+        kGranularity = 16,
+        kMaxBlockSize = 512,
+        kSlabSize = 64 * 1024,
+    };
+
+protected:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    std::vector<FreeBlock*> m_freeLists;
+    std::vector<char*> m_slabs;
+    char* m_cursor = nullptr;
+    char* m_end = nullptr;
+    bool m_releasing = false;
+    Stats m_stats;
+
+protected:
+    static size_t GetSizeClass(size_t size) { return (size == 0) ? 0 : ((size - 1) / kGranularity); }
+
+public:
+    clMemoryPool();
+    ~clMemoryPool();
+
+    /**
+     * @brief allocate 'size' bytes, aligned to kGranularity
+     */
+    void* Allocate(size_t size);
+    /**
+     * @brief return a block to the pool. 'size' must be the size passed to Allocate()
+     */
+    void Free(void* ptr, size_t size);
+    /**
+     * @brief release all the memory held by the pool at once. Calls to Free() made by 'destroyFunc' (e.g. the
+     * destructors of the objects living in the pool) are ignored
+     */
+    void Release(const std::function<void()>& destroyFunc = nullptr);
+
+    const Stats& GetStats() const { return m_stats; }
+};
+
+/**
+ * @brief STL allocator on top of clMemoryPool. A default constructed allocator uses the global heap
+ */
+template <typename T> class clPoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    clMemoryPool* m_pool = nullptr;
+
+public:
+    clPoolAllocator(clMemoryPool* pool = nullptr)
+        : m_pool(pool)
+    {
+    }
+    template <typename U>
+    clPoolAllocator(const clPoolAllocator<U>& other)
+        : m_pool(other.m_pool)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if(m_pool) {
+            return static_cast<T*>(m_pool->Allocate(n * sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if(m_pool) {
+            m_pool->Free(p, n * sizeof(T));
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    template <typename U> bool operator==(const clPoolAllocator<U>& other) const { return m_pool == other.m_pool; }
+    template <typename U> bool operator!=(const clPoolAllocator<U>& other) const { return m_pool != other.m_pool; }
+};
+
+#endif // CLMEMORYPOOL_H
@@ -0,0 +1,93 @@
+#ifndef CLPARALLELSORT_H
+#define CLPARALLELSORT_H
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief stable sort [first, last) using all the available cores. The range is split into one chunk per thread, the
+ * chunks are sorted concurrently and then merged (pairs of chunks are merged concurrently as well). Small ranges are
+ * sorted on the calling thread. 'comp' is called from several threads at once, it must not modify shared state
+ */
+template <typename RandomIt, typename Compare>
+void clParallelStableSort(RandomIt first, RandomIt last, Compare comp, size_t minChunkSize = 32768)
+{
+    size_t count = std::distance(first, last);
+    size_t threadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t chunksCount = std::min(threadsCount, count / std::max(minChunkSize, (size_t)1));
+    if(chunksCount < 2) {
+        std::stable_sort(first, last, comp);
+        return;
+    }
+
+    // The chunks boundaries
+    std::vector<RandomIt> bounds;
+    bounds.reserve(chunksCount + 1);
+    for(size_t i = 0; i < chunksCount; ++i) {
+        bounds.push_back(first + (count * i / chunksCount));
+    }
+    bounds.push_back(last);
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunksCount);
+    for(size_t i = 0; i < chunksCount; ++i) {
+        threads.emplace_back([&bounds, &comp, i]() { std::stable_sort(bounds[i], bounds[i + 1], comp); });
+    }
+    for(std::thread& t : threads) {
+        t.join();
+    }
+
+    // Merge neighbouring chunks until a single chunk is left. Merging keeps the order of equal elements as the left
+    // chunk always comes first
+    while(bounds.size() > 2) {
+        threads.clear();
+        std::vector<RandomIt> merged;
+        merged.reserve((bounds.size() / 2) + 1);
+        size_t i = 0;
+        for(; (i + 2) < bounds.size(); i += 2) {
+            threads.emplace_back(
+                [&bounds, &comp, i]() { std::inplace_merge(bounds[i], bounds[i + 1], bounds[i + 2], comp); });
+            merged.push_back(bounds[i]);
+        }
+        // An odd chunk is carried to the next round as is
+        for(; (i + 1) < bounds.size(); ++i) {
+            merged.push_back(bounds[i]);
+        }
+        merged.push_back(last);
+        for(std::thread& t : threads) {
+            t.join();
+        }
+        bounds.swap(merged);
+    }
+}
+
+/**
+ * @brief split [0, count) into one range per thread and call 'func(begin, end, index)' for each range concurrently,
+ * 'index' being the range index. Return the number of ranges used (small counts are processed by the calling thread
+ * as a single range)
+ */
+template <typename Func> size_t clParallelForRanges(size_t count, Func func, size_t minRangeSize = 32768)
+{
+    size_t threadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t rangesCount = std::min(threadsCount, count / std::max(minRangeSize, (size_t)1));
+    if(rangesCount < 2) {
+        func((size_t)0, count, (size_t)0);
+        return 1;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(rangesCount);
+    for(size_t i = 0; i < rangesCount; ++i) {
+        size_t begin = count * i / rangesCount;
+        size_t end = count * (i + 1) / rangesCount;
+        threads.emplace_back([&func, begin, end, i]() { func(begin, end, i); });
+    }
+    for(std::thread& t : threads) {
+        t.join();
+    }
+    return rangesCount;
+}
+
+#endif // CLPARALLELSORT_H
@@ -1,4 +1,5 @@
 #include "clCellValue.h"
+#include "clChildrenIndex.h"
 #include "clHeaderBar.h"
 #include "clHeaderItem.h"
 #include "clRowEntry.h"
@@ -6,6 +7,7 @@
 #include <algorithm>
 #include <drawingutils.h>
 #include <functional>
+#include <iterator>
 #include <wx/dataview.h>
 #include <wx/dc.h>
 #include <wx/renderer.h>
@@ -18,6 +20,9 @@
 
 namespace
 {
+// Below this many children, the positions and offsets are found by scanning the children list
+const size_t kChildrenIndexMinSize = 64;
+
 struct clClipperHelper {
     bool m_used = false;
     wxRect m_oldRect;
@@ -99,18 +104,20 @@ void clRowEntry::DrawSimpleSelection(wxWindow* win, wxDC& dc, const wxRect& rect
 clRowEntry::clRowEntry(clTreeCtrl* tree, const wxString& label, int bitmapIndex, int bitmapSelectedIndex)
     : m_tree(tree)
     , m_model(tree ? &tree->GetModel() : nullptr)
+    , m_cells(clPoolAllocator<clCellValue>(m_model ? m_model->GetMemoryPool() : nullptr))
 {
     // Fill the verctor with items constructed using the _non_ default constructor
     // to makes sure that IsOk() returns TRUE
-    m_cells.resize(m_tree->GetHeader()->empty() ? 1 : m_tree->GetHeader()->size(),
-                   clCellValue("", -1, -1)); // at least one column
-    clCellValue cv(label, bitmapIndex, bitmapSelectedIndex);
-    m_cells[0] = cv;
+    size_t count = m_tree->GetHeader()->empty() ? 1 : m_tree->GetHeader()->size(); // at least one column
+    m_cells.reserve(count);
+    m_cells.emplace_back(label, bitmapIndex, bitmapSelectedIndex);
+    m_cells.resize(count, clCellValue("", -1, -1));
 }
 
 clRowEntry::clRowEntry(clTreeCtrl* tree, bool checked, const wxString& label, int bitmapIndex, int bitmapSelectedIndex)
     : m_tree(tree)
     , m_model(tree ? &tree->GetModel() : nullptr)
+    , m_cells(clPoolAllocator<clCellValue>(m_model ? m_model->GetMemoryPool() : nullptr))
 {
     // Fill the verctor with items constructed using the _non_ default constructor
     // to makes sure that IsOk() returns TRUE
@@ -120,16 +127,59 @@ clRowEntry::clRowEntry(clTreeCtrl* tree, bool checked, const wxString& label, in
     m_cells[0] = cv;
 }
 
+namespace
+{
+// Every row is prefixed with the pool it was allocated from (null for the global heap). The header size keeps the
+// row itself aligned the same way the pool blocks are
+struct clRowEntryHeader {
+    clMemoryPool* pool;
+};
+const size_t ROW_HEADER_SIZE = clMemoryPool::kGranularity;
+} // namespace
+
+void* clRowEntry::operator new(size_t size) { return operator new(size, nullptr); }
+
+void* clRowEntry::operator new(size_t size, clMemoryPool* pool)
+{
+    size_t total = size + ROW_HEADER_SIZE;
+    char* block = static_cast<char*>(pool ? pool->Allocate(total) : ::operator new(total));
+    reinterpret_cast<clRowEntryHeader*>(block)->pool = pool;
+    return block + ROW_HEADER_SIZE;
+}
+
+void clRowEntry::operator delete(void* ptr, size_t size)
+{
+    if(!ptr) {
+        return;
+    }
+    char* block = static_cast<char*>(ptr) - ROW_HEADER_SIZE;
+    clMemoryPool* pool = reinterpret_cast<clRowEntryHeader*>(block)->pool;
+    if(pool) {
+        pool->Free(block, size + ROW_HEADER_SIZE);
+    } else {
+        ::operator delete(block);
+    }
+}
+
+void clRowEntry::operator delete(void* ptr, clMemoryPool* pool)
+{
+    // Called only if the constructor throws. The pool is also recorded in the row header
+    wxUnusedVar(pool);
+    operator delete(ptr, sizeof(clRowEntry));
+}
+
 clRowEntry::~clRowEntry()
 {
     // Delete all the node children
     DeleteAllChildren();
-    wxDELETE(m_clientObject);
 
-    // Notify the model that a selection is being deleted
+    // Notify the model that a selection is being deleted. The client data is still there for its listeners
     if(m_model) {
         m_model->NodeDeleted(this);
     }
+    wxDELETE(m_clientObject);
+    wxDELETE(m_highlightInfo);
+    wxDELETE(m_childrenIndex);
 }
 
 void clRowEntry::ConnectNodes(clRowEntry* first, clRowEntry* second)
@@ -146,45 +196,159 @@ void clRowEntry::ConnectNodes(clRowEntry* first, clRowEntry* second)
 
 void clRowEntry::InsertChild(clRowEntry* child, clRowEntry* prev)
 {
-    child->SetParent(this);
-    child->SetIndentsCount(GetIndentsCount() + 1);
-
-    // We need the last item of this subtree (prev 'this' is the root)
+    size_t index = 0;
     if(prev == nullptr) {
         // make it the first item
-        m_children.insert(m_children.begin(), child);
+        index = 0;
+    } else if(!m_children.empty() && (prev == m_children.back())) {
+        // appending, no need to search for 'prev'
+        index = m_children.size();
     } else {
-        // Insert the item in the parent children list
-        clRowEntry::Vec_t::iterator iter = m_children.end();
-        iter = std::find_if(m_children.begin(), m_children.end(), [&](clRowEntry* c) { return c == prev; });
-        if(iter != m_children.end()) {
-            ++iter;
-        }
-        // if iter is end(), than the is actually appending the item
-        m_children.insert(iter, child);
+        // if 'prev' is not found, the item is appended
+        clRowEntry::Vec_t::iterator iter =
+            std::find_if(m_children.begin(), m_children.end(), [&](clRowEntry* c) { return c == prev; });
+        index = (iter == m_children.end()) ? m_children.size() : ((iter - m_children.begin()) + 1);
     }
+    InsertChildAt(child, index);
+}
 
-    // Connect the linked list for sequential iteration
-    clRowEntry::Vec_t::iterator iterCur =
-        std::find_if(m_children.begin(), m_children.end(), [&](clRowEntry* c) { return c == child; });
-
-    clRowEntry* nodeBefore = nullptr;
-    // Find the item before and after
-    if(iterCur == m_children.begin()) {
-        nodeBefore = child->GetParent(); // "this"
-    } else {
-        --iterCur;
-        clRowEntry* prevSibling = (*iterCur);
-        while(prevSibling && prevSibling->HasChildren()) {
-            prevSibling = prevSibling->GetLastChild();
+void clRowEntry::InsertChildAt(clRowEntry* child, size_t index)
+{
+    RowsWillChange();
+    child->SetParent(this);
+    child->SetIndentsCount(GetIndentsCount() + 1);
+    child->SetFlag(kNF_ParentCollapsed, HasFlag(kNF_ParentCollapsed) || !IsExpanded());
+    child->UpdateChildrenVisibility();
+
+    index = std::min(index, m_children.size());
+    m_children.insert(m_children.begin() + index, child);
+    child->m_indexInParent = m_childrenIndex ? m_childrenIndex->Insert(index, child->m_rowsCount) : index;
+
+    // Connect the linked list for sequential iteration: the item comes after the last item of the previous sibling's
+    // subtree (or after 'this' for the first child)
+    clRowEntry* nodeBefore = this;
+    if(index > 0) {
+        nodeBefore = m_children[index - 1];
+        while(nodeBefore->HasChildren()) {
+            nodeBefore = nodeBefore->GetLastChild();
         }
-        nodeBefore = prevSibling;
     }
     child->ConnectNodes(nodeBefore, nodeBefore->m_next);
+
+    // Update the visible rows count
+    m_childrenRowsCount += child->m_rowsCount;
+    UpdateRowsCount();
 }
 
 void clRowEntry::AddChild(clRowEntry* child) { InsertChild(child, m_children.empty() ? nullptr : m_children.back()); }
 
+void clRowEntry::InsertChildrenAt(const clRowEntry::Vec_t& children, size_t index)
+{
+    if(children.empty()) {
+        return;
+    }
+    RowsWillChange();
+    index = std::min(index, m_children.size());
+
+    // The new items go between the last item of the previous sibling subtree (or this item) and the item following it
+    clRowEntry* nodeBefore = (index > 0) ? m_children[index - 1]->GetLastDescendant() : this;
+    clRowEntry* nodeAfter = nodeBefore->m_next;
+    m_children.insert(m_children.begin() + index, children.begin(), children.end());
+
+    bool collapsed = HasFlag(kNF_ParentCollapsed) || !IsExpanded();
+    for(size_t i = 0; i < children.size(); ++i) {
+        clRowEntry* child = children[i];
+        child->SetParent(this);
+        child->SetIndentsCount(GetIndentsCount() + 1);
+        child->SetFlag(kNF_ParentCollapsed, collapsed);
+        child->m_indexInParent = index + i;
+        m_childrenRowsCount += child->m_rowsCount;
+        nodeBefore->m_next = child;
+        child->m_prev = nodeBefore;
+        nodeBefore = child;
+    }
+    nodeBefore->m_next = nodeAfter;
+    if(nodeAfter) {
+        nodeAfter->m_prev = nodeBefore;
+    }
+    if(m_childrenIndex) {
+        std::vector<uint32_t> rows;
+        std::vector<clChildrenIndex::Handle_t> handles;
+        rows.reserve(children.size());
+        for(clRowEntry* child : children) {
+            rows.push_back((uint32_t)child->m_rowsCount);
+        }
+        m_childrenIndex->Insert(index, rows, handles);
+        for(size_t i = 0; i < children.size(); ++i) {
+            children[i]->m_indexInParent = handles[i];
+        }
+    }
+    UpdateRowsCount();
+}
+
+void clRowEntry::AddChildren(const clRowEntry::Vec_t& children,
+                             const std::function<bool(clRowEntry*, clRowEntry*)>& lessThan)
+{
+    if(children.empty()) {
+        return;
+    }
+    if(!lessThan) {
+        InsertChildrenAt(children, m_children.size());
+        return;
+    }
+    RowsWillChange();
+
+    // The item that follows this subtree
+    clRowEntry* nodeAfter = this;
+    while(nodeAfter->HasChildren()) {
+        nodeAfter = nodeAfter->GetLastChild();
+    }
+    nodeAfter = nodeAfter->m_next;
+
+    // Place the new items. With a sort function, new items go after the existing equal ones, like inserting them one
+    // by one would
+    size_t firstModified =
+        std::upper_bound(m_children.begin(), m_children.end(), children.front(), lessThan) - m_children.begin();
+    clRowEntry::Vec_t merged;
+    merged.reserve(m_children.size() + children.size());
+    std::merge(m_children.begin(), m_children.end(), children.begin(), children.end(), std::back_inserter(merged),
+               lessThan);
+    m_children.swap(merged);
+    DoDropChildrenIndex();
+
+    // Re-link the modified part of the sequential list. The new items are initialised on the way
+    bool collapsed = HasFlag(kNF_ParentCollapsed) || !IsExpanded();
+    clRowEntry* nodeBefore = this;
+    if(firstModified > 0) {
+        nodeBefore = m_children[firstModified - 1];
+        while(nodeBefore->HasChildren()) {
+            nodeBefore = nodeBefore->GetLastChild();
+        }
+    }
+    for(size_t i = firstModified; i < m_children.size(); ++i) {
+        clRowEntry* child = m_children[i];
+        if(child->m_parent != this) {
+            child->SetParent(this);
+            child->SetIndentsCount(GetIndentsCount() + 1);
+            child->SetFlag(kNF_ParentCollapsed, collapsed);
+            m_childrenRowsCount += child->m_rowsCount;
+        }
+        nodeBefore->m_next = child;
+        child->m_prev = nodeBefore;
+        nodeBefore = child;
+        while(nodeBefore->HasChildren()) {
+            nodeBefore = nodeBefore->GetLastChild();
+        }
+    }
+    nodeBefore->m_next = nodeAfter;
+    if(nodeAfter) {
+        nodeAfter->m_prev = nodeBefore;
+    }
+
+    // Update the visible rows count, once
+    UpdateRowsCount();
+}
+
 void clRowEntry::SetParent(clRowEntry* parent)
 {
     if(m_parent == parent) {
@@ -198,13 +362,10 @@ void clRowEntry::SetParent(clRowEntry* parent)
 
 void clRowEntry::DeleteChild(clRowEntry* child)
 {
+    RowsWillChange();
     // first remove all of its children
-    // do this in a while loop since 'child->RemoveChild(c);' will alter
-    // the array and will invalidate all iterators
-    while(!child->m_children.empty()) {
-        clRowEntry* c = child->m_children[0];
-        child->DeleteChild(c);
-    }
+    child->DeleteAllChildren();
+
     // Connect the list
     clRowEntry* prev = child->m_prev;
     clRowEntry* next = child->m_next;
@@ -215,23 +376,143 @@ void clRowEntry::DeleteChild(clRowEntry* child)
         next->m_prev = prev;
     }
     // Now disconnect this child from this node
-    clRowEntry::Vec_t::iterator iter =
-        std::find_if(m_children.begin(), m_children.end(), [&](clRowEntry* c) { return c == child; });
-    if(iter != m_children.end()) {
-        m_children.erase(iter);
+    size_t index = DoGetChildIndex(child);
+    if(index < m_children.size()) {
+        m_children.erase(m_children.begin() + index);
+        if(m_childrenIndex) {
+            m_childrenIndex->Erase(index, 1);
+        }
+        m_childrenRowsCount -= child->m_rowsCount;
+        UpdateRowsCount();
     }
     wxDELETE(child);
 }
 
-int clRowEntry::GetExpandedLines() const
+void clRowEntry::UpdateRowsCount()
 {
-    clRowEntry* node = const_cast<clRowEntry*>(this);
-    int counter = 0;
+    clRowEntry* node = this;
     while(node) {
-        if(node->IsVisible()) {
-            ++counter;
+        size_t rows = (node->IsHidden() ? 0 : 1) + (node->IsExpanded() ? node->m_childrenRowsCount : 0);
+        if(rows == node->m_rowsCount) {
+            // nothing changed, no need to go further up
+            break;
         }
-        node = node->m_next;
+        clRowEntry* parent = node->m_parent;
+        size_t oldRows = node->m_rowsCount;
+        node->m_rowsCount = rows;
+        if(parent) {
+            parent->m_childrenRowsCount = parent->m_childrenRowsCount - oldRows + rows;
+            parent->ChildRowsCountChanged(node);
+        }
+        node = parent;
+    }
+}
+
+void clRowEntry::ChildRowsCountChanged(clRowEntry* child)
+{
+    if(m_childrenIndex) {
+        m_childrenIndex->SetRows(child->m_indexInParent, child->m_rowsCount);
+    }
+}
+
+void clRowEntry::DoEnsureChildrenIndex()
+{
+    if(m_childrenIndex || (m_children.size() < kChildrenIndexMinSize)) {
+        return;
+    }
+    std::vector<uint32_t> rows;
+    std::vector<clChildrenIndex::Handle_t> handles;
+    rows.reserve(m_children.size());
+    for(clRowEntry* child : m_children) {
+        rows.push_back((uint32_t)child->m_rowsCount);
+    }
+    m_childrenIndex = new clChildrenIndex();
+    m_childrenIndex->Insert(0, rows, handles);
+    for(size_t i = 0; i < m_children.size(); ++i) {
+        m_children[i]->m_indexInParent = handles[i];
+    }
+}
+
+void clRowEntry::DoDropChildrenIndex()
+{
+    if(!m_childrenIndex) {
+        return;
+    }
+    wxDELETE(m_childrenIndex);
+    // The handles are now used as position hints
+    for(size_t i = 0; i < m_children.size(); ++i) {
+        m_children[i]->m_indexInParent = i;
+    }
+}
+
+size_t clRowEntry::DoGetChildIndex(clRowEntry* child)
+{
+    DoEnsureChildrenIndex();
+    if(m_childrenIndex) {
+        return m_childrenIndex->GetIndex(child->m_indexInParent);
+    }
+    // Few children: check the hint before searching
+    size_t index = child->m_indexInParent;
+    if((index < m_children.size()) && (m_children[index] == child)) {
+        return index;
+    }
+    index = std::find(m_children.begin(), m_children.end(), child) - m_children.begin();
+    child->m_indexInParent = index;
+    return index;
+}
+
+size_t clRowEntry::GetIndexInParent()
+{
+    if(!m_parent) {
+        return 0;
+    }
+    return m_parent->DoGetChildIndex(this);
+}
+
+size_t clRowEntry::GetRowsOffsetInParent()
+{
+    if(!m_parent) {
+        return 0;
+    }
+    m_parent->DoEnsureChildrenIndex();
+    if(m_parent->m_childrenIndex) {
+        return m_parent->m_childrenIndex->GetRowsOffset(m_indexInParent);
+    }
+    size_t offset = 0;
+    for(clRowEntry* child : m_parent->m_children) {
+        if(child == this) {
+            break;
+        }
+        offset += child->m_rowsCount;
+    }
+    return offset;
+}
+
+clRowEntry* clRowEntry::GetChildAtRowsOffset(size_t& offset)
+{
+    if(offset >= m_childrenRowsCount) {
+        return nullptr;
+    }
+    DoEnsureChildrenIndex();
+    if(m_childrenIndex) {
+        return m_children[m_childrenIndex->FindRowsOffset(offset)];
+    }
+    for(clRowEntry* child : m_children) {
+        if(offset < child->m_rowsCount) {
+            return child;
+        }
+        offset -= child->m_rowsCount;
+    }
+    return nullptr;
+}
+
+int clRowEntry::GetExpandedLines() const
+{
+    int counter = IsVisible() ? 1 : 0;
+    clRowEntry* node = GetNextVisible();
+    while(node) {
+        ++counter;
+        node = node->GetNextVisible();
     }
     return counter;
 }
@@ -245,15 +526,10 @@ void clRowEntry::GetNextItems(int count, clRowEntry::Vec_t& items, bool selfIncl
     if(!this->IsHidden() && selfIncluded) {
         items.push_back(this);
     }
-    clRowEntry* next = GetNext();
-    while(next) {
-        if(next->IsVisible() && !next->IsHidden()) {
-            items.push_back(next);
-        }
-        if((int)items.size() == count) {
-            return;
-        }
-        next = next->GetNext();
+    clRowEntry* next = GetNextVisible();
+    while(next && ((int)items.size() < count)) {
+        items.push_back(next);
+        next = next->GetNextVisible();
     }
 }
 
@@ -262,19 +538,76 @@ void clRowEntry::GetPrevItems(int count, clRowEntry::Vec_t& items, bool selfIncl
     if(count <= 0) {
         return;
     }
-    items.reserve(count);
+    // Collect the items in reverse order and place them at the start of 'items' at once
+    clRowEntry::Vec_t prevItems;
+    prevItems.reserve(count);
     if(!this->IsHidden() && selfIncluded) {
-        items.insert(items.begin(), this);
+        prevItems.push_back(this);
     }
-    clRowEntry* prev = GetPrev();
-    while(prev) {
-        if(prev->IsVisible() && !prev->IsHidden()) {
-            items.insert(items.begin(), prev);
-        }
-        if((int)items.size() == count) {
-            return;
+    clRowEntry* prev = GetPrevVisible();
+    while(prev && ((int)(prevItems.size() + items.size()) < count)) {
+        prevItems.push_back(prev);
+        prev = prev->GetPrevVisible();
+    }
+    items.insert(items.begin(), prevItems.rbegin(), prevItems.rend());
+}
+
+clRowEntry* clRowEntry::GetLastDescendant() const
+{
+    const clRowEntry* node = this;
+    while(!node->m_children.empty()) {
+        node = node->m_children.back();
+    }
+    return const_cast<clRowEntry*>(node);
+}
+
+clRowEntry* clRowEntry::GetNextVisible() const
+{
+    const clRowEntry* node = this;
+    // If we are inside a collapsed subtree, start from the collapsed item itself
+    while(node->HasFlag(kNF_ParentCollapsed)) {
+        node = node->m_parent;
+    }
+    if(!node->IsExpanded()) {
+        // skip the entire subtree
+        node = node->GetLastDescendant();
+    }
+    return node->m_next;
+}
+
+clRowEntry* clRowEntry::GetPrevVisible() const
+{
+    // The previous item is either our parent or the last item of our previous sibling's subtree. If it is
+    // inside a collapsed subtree, the collapsed item is the visible one
+    clRowEntry* prev = m_prev;
+    while(prev && prev->HasFlag(kNF_ParentCollapsed)) {
+        prev = prev->m_parent;
+    }
+    if(prev && prev->IsHidden()) {
+        prev = prev->m_prev;
+    }
+    return prev;
+}
+
+void clRowEntry::UpdateChildrenVisibility()
+{
+    // Use an explicit stack (and not recursion) so very deep trees are safe
+    clRowEntry::Vec_t Q;
+    Q.push_back(this);
+    while(!Q.empty()) {
+        clRowEntry* node = Q.back();
+        Q.pop_back();
+        bool collapsed = node->HasFlag(kNF_ParentCollapsed) || !node->IsExpanded();
+        for(clRowEntry* child : node->m_children) {
+            if(child->HasFlag(kNF_ParentCollapsed) == collapsed) {
+                // this subtree is already up to date
+                continue;
+            }
+            child->SetFlag(kNF_ParentCollapsed, collapsed);
+            if(child->IsExpanded() && child->HasChildren()) {
+                Q.push_back(child);
+            }
         }
-        prev = prev->GetPrev();
     }
 }
 
@@ -290,10 +623,26 @@ clRowEntry* clRowEntry::GetVisibleItem(int index)
 
 void clRowEntry::UnselectAll()
 {
-    clRowEntry* item = const_cast<clRowEntry*>(this);
-    while(item) {
-        item->SetSelected(false);
-        item = item->GetNext();
+    if(m_model) {
+        m_model->UnselectAll();
+    }
+}
+
+bool clRowEntry::IsSelected() const { return HasFlag(kNF_Selected) || (m_model && m_model->IsInSelectedRanges(this)); }
+
+clRowEntry::Vec_t& clRowEntry::GetChildrenForUpdate()
+{
+    RowsWillChange();
+    DoDropChildrenIndex();
+    return m_children;
+}
+
+void clRowEntry::RowsWillChange()
+{
+    // The selected rows ranges are made of row indexes, convert them into selected items while the rows are still in
+    // place
+    if(m_model) {
+        m_model->FlushSelectedRanges();
     }
 }
 
@@ -309,7 +658,10 @@ bool clRowEntry::SetExpanded(bool b)
 
     if(IsHidden()) {
         // Hidden node do not fire events
+        RowsWillChange();
         SetFlag(kNF_Expanded, b);
+        UpdateRowsCount();
+        UpdateChildrenVisibility();
         return true;
     }
 
@@ -326,15 +678,73 @@ bool clRowEntry::SetExpanded(bool b)
         return false;
     }
 
+    RowsWillChange();
     SetFlag(kNF_Expanded, b);
+    UpdateRowsCount();
+    UpdateChildrenVisibility();
     m_model->NodeExpanded(this, b);
     return true;
 }
 
-void clRowEntry::ClearRects()
+void clRowEntry::SetSubtreeExpanded(bool b)
 {
-    m_buttonRect = wxRect();
-    m_rowRect = wxRect();
+    RowsWillChange();
+    // The subtree is [this, last descendant] in the flattened list. Parents come before their children, so a single
+    // forward pass can set both the expanded flags and the visibility
+    clRowEntry* last = GetLastDescendant();
+    clRowEntry* node = this;
+    while(true) {
+        if(node->HasChildren() && !node->IsHidden()) {
+            node->SetFlag(kNF_Expanded, b);
+        }
+        node->m_childrenRowsCount = 0;
+        node->DoDropChildrenIndex();
+        if(node != this) {
+            clRowEntry* parent = node->m_parent;
+            node->SetFlag(kNF_ParentCollapsed, parent->HasFlag(kNF_ParentCollapsed) || !parent->IsExpanded());
+        }
+        if(node == last) {
+            break;
+        }
+        node = node->m_next;
+    }
+
+    // The rows count of a node depends on its children: go backward, the children are complete before their parent
+    while(node != this) {
+        node->m_rowsCount = (node->IsHidden() ? 0 : 1) + (node->IsExpanded() ? node->m_childrenRowsCount : 0);
+        node->m_parent->m_childrenRowsCount += node->m_rowsCount;
+        node = node->m_prev;
+    }
+    // This also updates the parents
+    UpdateRowsCount();
+}
+
+void clRowEntry::SetHighlightInfo(const clMatchResult& info)
+{
+    if(info.matches.empty()) {
+        wxDELETE(m_highlightInfo);
+        return;
+    }
+    if(!m_highlightInfo) {
+        m_highlightInfo = new clMatchResult();
+    }
+    *m_highlightInfo = info;
+}
+
+const clMatchResult& clRowEntry::GetHighlightInfo() const
+{
+    if(!m_highlightInfo) {
+        static clMatchResult emptyResult;
+        return emptyResult;
+    }
+    return *m_highlightInfo;
+}
+
+void clRowEntry::ClearFormatCache()
+{
+    for(const clCellValue& cell : m_cells) {
+        cell.ClearFormatCache();
+    }
 }
 
 #if 0
@@ -388,21 +798,19 @@ void clRowEntry::Render(wxWindow* win, wxDC& dc, const clColours& c, int row_ind
     }
 
     // Per cell drawings
+    const wxFont defaultFont = m_tree->GetDefaultFont();
     for(size_t i = 0; i < m_cells.size(); ++i) {
         bool last_cell = (i == (m_cells.size() - 1));
         colours = c; // reset the colours
         clCellValue& cell = GetColumn(i);
-        wxFont f = cell.GetFont().IsOk() ? cell.GetFont() : m_tree->GetDefaultFont();
-        if(cell.GetFont().IsOk()) {
-            f = cell.GetFont();
+        const clCellStyle& style = cell.GetStyle();
+        if(style.textColour.IsOk()) {
+            colours.SetItemTextColour(style.textColour);
         }
-        if(cell.GetTextColour().IsOk()) {
-            colours.SetItemTextColour(cell.GetTextColour());
+        if(style.bgColour.IsOk()) {
+            colours.SetItemBgColour(style.bgColour);
         }
-        if(cell.GetBgColour().IsOk()) {
-            colours.SetItemBgColour(cell.GetBgColour());
-        }
-        dc.SetFont(f);
+        dc.SetFont(style.font.IsOk() ? style.font : defaultFont);
         wxColour buttonColour = IsSelected() ? colours.GetSelItemTextColour() : colours.GetItemTextColour();
         wxRect cellRect = GetCellRect(i);
 
@@ -416,15 +824,12 @@ void clRowEntry::Render(wxWindow* win, wxDC& dc, const clColours& c, int row_ind
         int textXOffset = cellRect.GetX();
         if((i == 0) && !IsListItem()) {
             // The expand button is only make sense for the first cell
-            if(HasChildren()) {
-                wxRect buttonRect = GetButtonRect();
-                buttonRect.Deflate(1);
-                textXOffset += buttonRect.GetWidth();
-
-                buttonRect = GetButtonRect();
+            if(HasButton()) {
+                wxRect buttonRect(GetIndentsCount() * m_tree->GetIndent(), rowRect.GetY(), rowRect.GetHeight(),
+                                  rowRect.GetHeight());
+                textXOffset += buttonRect.GetWidth() - 2; // the button is drawn deflated by 1 pixel
                 if(textXOffset >= cellRect.GetWidth()) {
                     // if we cant draw the button (off screen etc)
-                    SetRects(GetItemRect(), wxRect());
                     continue;
                 }
 
@@ -455,7 +860,6 @@ void clRowEntry::Render(wxWindow* win, wxDC& dc, const clColours& c, int row_ind
                 buttonRect.Deflate(1);
                 textXOffset += buttonRect.GetWidth();
                 if(textXOffset >= cellRect.GetWidth()) {
-                    SetRects(GetItemRect(), wxRect());
                     continue;
                 }
             }
@@ -467,19 +871,16 @@ void clRowEntry::Render(wxWindow* win, wxDC& dc, const clColours& c, int row_ind
         }
 
         // Draw checkbox
+        wxRect checkboxRect;
+        wxRect dropDownRect;
+        GetCellLayout(i, rowRect, checkboxRect, dropDownRect);
         if(cell.IsBool()) {
             // Render the checkbox
             textXOffset += X_SPACER;
-            int checkboxSize = GetCheckBoxWidth(win);
-            wxRect checkboxRect = wxRect(textXOffset, rowRect.GetY(), checkboxSize, checkboxSize);
-            checkboxRect = checkboxRect.CenterIn(rowRect, wxVERTICAL);
             dc.SetPen(colours.GetItemTextColour());
             RenderCheckBox(win, dc, colours, checkboxRect, cell.GetValueBool());
-            cell.SetCheckboxRect(checkboxRect);
             textXOffset += checkboxRect.GetWidth();
             textXOffset += X_SPACER;
-        } else {
-            cell.SetCheckboxRect(wxRect()); // clear the checkbox rect
         }
 
         // Draw the bitmap
@@ -506,12 +907,7 @@ void clRowEntry::Render(wxWindow* win, wxDC& dc, const clColours& c, int row_ind
 
         if(cell.IsChoice()) {
             // draw the drop down arrow. Make it aligned to the right
-            wxRect dropDownRect(cellRect.GetTopRight().x - rowRect.GetHeight(), rowRect.GetY(), rowRect.GetHeight(),
-                                rowRect.GetHeight());
-            dropDownRect = dropDownRect.CenterIn(rowRect, wxVERTICAL);
             DrawingUtils::DrawDropDownArrow(win, dc, dropDownRect, wxNullColour);
-            // Keep the rect to test clicks
-            cell.SetDropDownRect(dropDownRect);
             textXOffset += dropDownRect.GetWidth();
             textXOffset += X_SPACER;
 
@@ -520,11 +916,7 @@ void clRowEntry::Render(wxWindow* win, wxDC& dc, const clColours& c, int row_ind
             dropDownRect = dropDownRect.CenterIn(rowRect, wxVERTICAL);
             dc.SetPen(wxPen(colours.GetHeaderVBorderColour(), 1, PEN_STYLE));
             dc.DrawLine(dropDownRect.GetTopLeft(), dropDownRect.GetBottomLeft());
-
-        } else {
-            cell.SetDropDownRect(wxRect());
         }
-
         if(!last_cell) {
             cellRect.SetHeight(rowRect.GetHeight());
             dc.SetPen(wxPen(colours.GetHeaderVBorderColour(), 1, PEN_STYLE));
@@ -620,27 +1012,62 @@ size_t clRowEntry::GetChildrenCount(bool recurse) const
     }
 }
 
-bool clRowEntry::IsVisible() const
+void clRowEntry::DeleteAllChildren() { DeleteChildren(0, m_children.size()); }
+
+void clRowEntry::DeleteChildren(size_t first, size_t count)
 {
-    if(IsHidden()) {
-        return false;
+    if(first >= m_children.size()) {
+        return;
     }
-    clRowEntry* parent = GetParent();
-    while(parent) {
-        if(!parent->IsExpanded()) {
-            return false;
+    count = std::min(count, m_children.size() - first);
+    if(count == 0) {
+        return;
+    }
+    RowsWillChange();
+
+    // The subtrees are placed one after the other in the flattened list: [first child, last descendant]
+    clRowEntry* firstNode = m_children[first];
+    clRowEntry* before = firstNode->m_prev;
+    clRowEntry* after = m_children[first + count - 1]->GetLastDescendant()->m_next;
+    for(clRowEntry* node = firstNode; node != after; node = node->m_next) {
+        node->SetFlag(kNF_Deleting, true);
+    }
+    for(size_t i = first; i < (first + count); ++i) {
+        m_childrenRowsCount -= m_children[i]->m_rowsCount;
+    }
+
+    // Detach the subtrees from the list
+    before->m_next = after;
+    if(after) {
+        after->m_prev = before;
+    }
+    if(count == m_children.size()) {
+        m_children.clear();
+        wxDELETE(m_childrenIndex);
+    } else {
+        m_children.erase(m_children.begin() + first, m_children.begin() + first + count);
+        if(m_childrenIndex) {
+            m_childrenIndex->Erase(first, count);
         }
-        parent = parent->GetParent();
     }
-    return true;
-}
+    UpdateRowsCount();
 
-void clRowEntry::DeleteAllChildren()
-{
-    while(!m_children.empty()) {
-        clRowEntry* c = m_children[0];
-        // DeleteChild will remove it from the array
-        DeleteChild(c);
+    // Let the model remove the marked items from its caches, in a single pass
+    bool selectionCleared = m_model && m_model->NodesDeleted(firstNode, after);
+
+    // Delete the items. Since the children arrays are cleared first, no destructor recurses
+    clRowEntry* node = firstNode;
+    while(node != after) {
+        clRowEntry* next = node->m_next;
+        node->m_children.clear();
+        node->m_model = nullptr; // the model was already notified
+        delete node;
+        node = next;
+    }
+
+    // Dont leave the tree without a selected item
+    if(selectionCleared && after) {
+        m_model->SelectItem(wxTreeItemId(after));
     }
 }
 
@@ -665,12 +1092,15 @@ void clRowEntry::SetHidden(bool b)
     if(b && !IsRoot()) {
         return;
     }
+    RowsWillChange();
     SetFlag(kNF_Hidden, b);
     if(b) {
         m_indentsCount = -1;
     } else {
         m_indentsCount = 0;
     }
+    UpdateRowsCount();
+    UpdateChildrenVisibility();
 }
 
 int clRowEntry::CalcItemWidth(wxDC& dc, int rowHeight, size_t col)
@@ -681,11 +1111,12 @@ int clRowEntry::CalcItemWidth(wxDC& dc, int rowHeight, size_t col)
     }
 
     clCellValue& cell = GetColumn(col);
-    wxFont f = GetFont().IsOk() ? GetFont() : m_tree->GetDefaultFont();
-    if(cell.GetFont().IsOk()) {
-        f = cell.GetFont();
+    const wxFont& cellFont = cell.GetFont().IsOk() ? cell.GetFont() : GetFont();
+    wxFont font = cellFont.IsOk() ? cellFont : m_tree->GetDefaultFont();
+    // When measuring many rows, the font is usually the same: don't set it again
+    if(dc.GetFont() != font) {
+        dc.SetFont(font);
     }
-    dc.SetFont(f);
 
     int item_width = X_SPACER;
     if(cell.IsBool()) {
@@ -697,7 +1128,12 @@ int clRowEntry::CalcItemWidth(wxDC& dc, int rowHeight, size_t col)
         item_width += X_SPACER;
     }
 
+    // Measuring a numeric cell should not keep its text around
+    bool formatted = cell.IsFormatted();
     wxSize textSize = dc.GetTextExtent(cell.GetValueString());
+    if(!formatted) {
+        cell.ClearFormatCache();
+    }
     if((col == 0) && !IsListItem()) {
         // always make room for the twist button
         item_width += rowHeight;
@@ -769,6 +1205,41 @@ void clRowEntry::SetLabel(const wxString& label, size_t col)
     cell.SetValue(label);
 }
 
+void clRowEntry::SetValueInt64(wxLongLong_t value, size_t col)
+{
+    clCellValue& cell = GetColumn(col);
+    if(!cell.IsOk()) {
+        return;
+    }
+    cell.SetValueInt64(value);
+}
+
+void clRowEntry::SetValueDouble(double value, size_t col)
+{
+    clCellValue& cell = GetColumn(col);
+    if(!cell.IsOk()) {
+        return;
+    }
+    cell.SetValueDouble(value);
+}
+
+void clRowEntry::SetValueDateTime(const wxDateTime& value, size_t col)
+{
+    clCellValue& cell = GetColumn(col);
+    if(!cell.IsOk()) {
+        return;
+    }
+    cell.SetValueDateTime(value);
+}
+
+void clRowEntry::SetCellValue(const clCellValue& value, size_t col)
+{
+    if(col >= m_cells.size()) {
+        m_cells.resize(col + 1, clCellValue("", -1, -1));
+    }
+    m_cells[col] = value;
+}
+
 const wxString& clRowEntry::GetLabel(size_t col) const
 {
     const clCellValue& cell = GetColumn(col);
@@ -876,13 +1347,35 @@ const wxColour& clRowEntry::GetTextColour(size_t col) const
     return cell.GetTextColour();
 }
 
+wxRect clRowEntry::GetItemRect() const
+{
+    if(!m_tree || IsHidden() || (m_onScreenIndex == wxNOT_FOUND)) {
+        return wxRect();
+    }
+    return m_tree->GetRowRect(m_onScreenIndex);
+}
+
+wxRect clRowEntry::GetButtonRect() const
+{
+    wxRect rowRect = GetItemRect();
+    if(rowRect.IsEmpty() || !HasButton()) {
+        return wxRect();
+    }
+    // Render skips the button when it does not fit in the first column
+    wxRect cellRect = GetCellRect(0);
+    if((cellRect.GetX() + rowRect.GetHeight() - 2) >= cellRect.GetWidth()) {
+        return wxRect();
+    }
+    return wxRect(GetIndentsCount() * m_tree->GetIndent(), rowRect.GetY(), rowRect.GetHeight(), rowRect.GetHeight());
+}
+
 wxRect clRowEntry::GetCellRect(size_t col) const
 {
     if(m_tree && m_tree->GetHeader() && (col < m_tree->GetHeader()->size())) {
         // Check which column was clicked
         wxRect cellRect = m_tree->GetHeader()->Item(col).GetRect();
 
-        const wxRect& itemRect = GetItemRect();
+        wxRect itemRect = GetItemRect();
         // Make sure that the cellRect has all the correct attributes of the row
         cellRect.SetY(itemRect.GetY());
         // If we got h-scrollbar, adjust the X coordinate
@@ -894,24 +1387,57 @@ wxRect clRowEntry::GetCellRect(size_t col) const
     }
 }
 
-const wxRect& clRowEntry::GetCheckboxRect(size_t col) const
+wxRect clRowEntry::GetCheckboxRect(size_t col) const
 {
-    const clCellValue& cell = GetColumn(col);
-    if(!cell.IsOk()) {
-        static wxRect emptyRect;
-        return emptyRect;
-    }
-    return cell.GetCheckboxRect();
+    wxRect checkboxRect;
+    wxRect dropDownRect;
+    GetCellLayout(col, GetItemRect(), checkboxRect, dropDownRect);
+    return checkboxRect;
 }
 
-const wxRect& clRowEntry::GetChoiceRect(size_t col) const
+wxRect clRowEntry::GetChoiceRect(size_t col) const
 {
+    wxRect checkboxRect;
+    wxRect dropDownRect;
+    GetCellLayout(col, GetItemRect(), checkboxRect, dropDownRect);
+    return dropDownRect;
+}
+
+bool clRowEntry::GetCellLayout(size_t col, const wxRect& rowRect, wxRect& checkboxRect, wxRect& dropDownRect) const
+{
+    checkboxRect = wxRect();
+    dropDownRect = wxRect();
+    if(rowRect.IsEmpty() || (col >= m_cells.size())) {
+        return false;
+    }
+    wxRect cellRect = rowRect;
+    if(m_tree && m_tree->GetHeader() && (col < m_tree->GetHeader()->size())) {
+        cellRect = m_tree->GetHeader()->Item(col).GetRect();
+        cellRect.SetY(rowRect.GetY());
+        cellRect.SetHeight(rowRect.GetHeight());
+    }
+
+    int x = cellRect.GetX();
+    if((col == 0) && !IsListItem()) {
+        // The first cell starts with the expand button (or the space for it)
+        x += rowRect.GetHeight() - 2;
+        if(x >= cellRect.GetWidth()) {
+            return false;
+        }
+    }
     const clCellValue& cell = GetColumn(col);
-    if(!cell.IsOk()) {
-        static wxRect emptyRect;
-        return emptyRect;
+    if(cell.IsBool()) {
+        int checkboxSize = GetCheckBoxWidth(m_tree);
+        checkboxRect = wxRect(x + X_SPACER, rowRect.GetY(), checkboxSize, checkboxSize);
+        checkboxRect = checkboxRect.CenterIn(rowRect, wxVERTICAL);
+    }
+    if(cell.IsChoice()) {
+        // Aligned to the right
+        dropDownRect = wxRect(cellRect.GetTopRight().x - rowRect.GetHeight(), rowRect.GetY(), rowRect.GetHeight(),
+                              rowRect.GetHeight());
+        dropDownRect = dropDownRect.CenterIn(rowRect, wxVERTICAL);
     }
-    return cell.GetDropDownRect();
+    return true;
 }
 
 void clRowEntry::RenderCheckBox(wxWindow* win, wxDC& dc, const clColours& colours, const wxRect& rect, bool checked)
@@ -931,7 +1457,7 @@ void clRowEntry::RenderCheckBox(wxWindow* win, wxDC& dc, const clColours& colour
     }
 }
 
-int clRowEntry::GetCheckBoxWidth(wxWindow* win)
+int clRowEntry::GetCheckBoxWidth(wxWindow* win) const
 {
     static int width = wxNOT_FOUND;
     if(width == wxNOT_FOUND) {
@@ -4,7 +4,9 @@
 #include "clCellValue.h"
 #include "clColours.h"
 #include "codelite_exports.h"
+#include <algorithm>
 #include <array>
+#include <functional>
 #include <unordered_map>
 #include <vector>
 #include <wx/colour.h>
@@ -13,6 +15,7 @@
 #include <wx/string.h>
 #include <wx/treebase.h>
 
+class clChildrenIndex;
 class clSearchText;
 class clTreeCtrlModel;
 class clTreeCtrl;
@@ -26,6 +29,9 @@ enum clTreeCtrlNodeFlags {
     kNF_Hidden = (1 << 6),
     kNF_LisItem = (1 << 7),
     kNF_HighlightText = (1 << 8),
+    kNF_ParentCollapsed = (1 << 9),  // one of the item's parents is collapsed
+    kNF_Deleting = (1 << 10),        // the item is about to be deleted as part of a subtree
+    kNF_VirtualChildren = (1 << 11), // the row displays an item of a virtual model which has children
 };
 
 typedef std::array<wxString, 3> Str3Arr_t;
@@ -55,20 +61,28 @@ public:
     static int X_SPACER;
 
 protected:
+    // The fields used by the traversal code (GetNext, GetNextVisible, GetItemIndex...) come first, so they share the
+    // object's first cache line
+    clRowEntry* m_next = nullptr;
+    clRowEntry* m_prev = nullptr;
+    clRowEntry* m_parent = nullptr;
+    size_t m_flags = 0;
+    int m_indentsCount = 0;
+    int m_onScreenIndex = wxNOT_FOUND; // the row's position in the on-screen rows, its rects are derived from it
+    size_t m_rowsCount = 1;         // visible rows in this subtree, this row included
+    size_t m_childrenRowsCount = 0; // the sum of m_rowsCount of the direct children
+    size_t m_indexInParent = 0;     // the handle in the parent's children index, else a hint of the position
+
+    clRowEntry::Vec_t m_children;
+    clChildrenIndex* m_childrenIndex = nullptr; // built for the items with many children only
+
+    // Data used when drawing or accessing the item
     clTreeCtrl* m_tree = nullptr;
     clTreeCtrlModel* m_model = nullptr;
     clCellValue::Vect_t m_cells;
-    size_t m_flags = 0;
     wxTreeItemData* m_clientObject = nullptr;
     wxUIntPtr m_data = 0;
-    clRowEntry* m_parent = nullptr;
-    clRowEntry::Vec_t m_children;
-    clRowEntry* m_next = nullptr;
-    clRowEntry* m_prev = nullptr;
-    int m_indentsCount = 0;
-    wxRect m_rowRect;
-    wxRect m_buttonRect;
-    clMatchResult m_higlightInfo;
+    clMatchResult* m_highlightInfo = nullptr; // allocated only while the item has search matches
 
 protected:
     void SetFlag(clTreeCtrlNodeFlags flag, bool b)
@@ -93,12 +107,71 @@ protected:
     void RenderTextSimple(wxWindow* win, wxDC& dc, const clColours& colours, const wxString& text, int x, int y,
                           size_t col);
     void RenderCheckBox(wxWindow* win, wxDC& dc, const clColours& colours, const wxRect& rect, bool checked);
-    int GetCheckBoxWidth(wxWindow* win);
+    int GetCheckBoxWidth(wxWindow* win) const;
+
+    /**
+     * @brief called before the rows of this subtree are added, removed or moved
+     */
+    void RowsWillChange();
+
+    /**
+     * @brief re-calculate the visible rows count of this subtree and propagate the change to the parents
+     */
+    void UpdateRowsCount();
+
+    /**
+     * @brief build the children index if there are enough children for it to pay off
+     */
+    void DoEnsureChildrenIndex();
+
+    /**
+     * @brief forget the children index, e.g. when the children were re-ordered. It is rebuilt when needed
+     */
+    void DoDropChildrenIndex();
+
+    /**
+     * @brief return the position of 'child' in the children list
+     */
+    size_t DoGetChildIndex(clRowEntry* child);
+
+    /**
+     * @brief the number of visible rows of 'child' was modified
+     */
+    void ChildRowsCountChanged(clRowEntry* child);
+
+    /**
+     * @brief push the "parent collapsed" state of this item down to its subtree. Only the items whose state
+     * was changed are visited
+     */
+    void UpdateChildrenVisibility();
 
 public:
     clRowEntry* GetLastChild() const;
     clRowEntry* GetFirstChild() const;
 
+    /**
+     * @brief return the last item of this subtree (by the flattened list order)
+     */
+    clRowEntry* GetLastDescendant() const;
+
+    /**
+     * @brief return the first visible item that comes after this one. Collapsed subtrees are skipped in one step
+     */
+    clRowEntry* GetNextVisible() const;
+
+    /**
+     * @brief return the first visible item that comes before this one
+     */
+    clRowEntry* GetPrevVisible() const;
+
+    /**
+     * @brief rows are allocated either from the global heap or, when the model has one, from its memory pool
+     */
+    static void* operator new(size_t size);
+    static void* operator new(size_t size, clMemoryPool* pool);
+    static void operator delete(void* ptr, size_t size);
+    static void operator delete(void* ptr, clMemoryPool* pool);
+
     clRowEntry(clTreeCtrl* tree, const wxString& label, int bitmapIndex = wxNOT_FOUND,
                int bitmapSelectedIndex = wxNOT_FOUND);
     clRowEntry(clTreeCtrl* tree, bool checked, const wxString& label, int bitmapIndex = wxNOT_FOUND,
@@ -113,8 +186,8 @@ public:
     clRowEntry* GetPrev() const { return m_prev; }
     void SetNext(clRowEntry* next) { this->m_next = next; }
     void SetPrev(clRowEntry* prev) { this->m_prev = prev; }
-    void SetHighlightInfo(const clMatchResult& info) { m_higlightInfo = info; }
-    const clMatchResult& GetHighlightInfo() const { return m_higlightInfo; }
+    void SetHighlightInfo(const clMatchResult& info);
+    const clMatchResult& GetHighlightInfo() const;
     void SetHidden(bool b);
     bool IsHidden() const { return HasFlag(kNF_Hidden); }
     void SetHighlight(bool b) { SetFlag(kNF_HighlightText, b); }
@@ -128,7 +201,10 @@ public:
     int CalcItemWidth(wxDC& dc, int rowHeight, size_t col = 0);
     bool IsListItem() const { return m_flags & kNF_LisItem; }
     void SetListItem(bool b) { SetFlag(kNF_LisItem, b); }
-    bool IsVisible() const;
+    /**
+     * @brief return true if all the parents of this item are expanded (hidden items are never visible)
+     */
+    bool IsVisible() const { return !HasFlag(kNF_Hidden) && !HasFlag(kNF_ParentCollapsed); }
     void SetBgColour(const wxColour& bgColour, size_t col = 0);
     void SetFont(const wxFont& font, size_t col = 0);
     void SetTextColour(const wxColour& textColour, size_t col = 0);
@@ -141,31 +217,68 @@ public:
      */
     void DeleteChild(clRowEntry* child);
     /**
-     * @brief remove all children items
+     * @brief remove all children items. The subtree is deleted in a single, non recursive, pass
      */
     void DeleteAllChildren();
+    /**
+     * @brief remove 'count' children (and their subtrees) starting at 'first', in a single pass
+     */
+    void DeleteChildren(size_t first, size_t count);
+    /**
+     * @brief return true if this item is marked for deletion (see DeleteAllChildren)
+     */
+    bool IsDeleting() const { return HasFlag(kNF_Deleting); }
     void Render(wxWindow* win, wxDC& dc, const clColours& colours, int row_index, clSearchText* searcher);
     void SetHovered(bool b) { SetFlag(kNF_Hovered, b); }
     bool IsHovered() const { return m_flags & kNF_Hovered; }
 
-    void ClearRects();
-    void SetRects(const wxRect& rect, const wxRect& buttonRect)
-    {
-        m_rowRect = rect;
-        m_buttonRect = buttonRect;
-    }
-    const wxRect& GetItemRect() const { return m_rowRect; }
-    const wxRect& GetButtonRect() const { return m_buttonRect; }
-    const wxRect& GetCheckboxRect(size_t col = 0) const;
-    const wxRect& GetChoiceRect(size_t col = 0) const;
+    /**
+     * @brief release the formatted text of the numeric and time cells (see clCellValue::ClearFormatCache)
+     */
+    void ClearFormatCache();
+    /**
+     * @brief the row's position in the list of rows drawn on screen (wxNOT_FOUND if it is not drawn). The row does
+     * not store its rects, they are computed from this position (see clControlWithItems::GetRowRect)
+     */
+    void SetOnScreenIndex(int index) { m_onScreenIndex = index; }
+    int GetOnScreenIndex() const { return m_onScreenIndex; }
+    wxRect GetItemRect() const;
+    /**
+     * @brief the expand button rect. Empty if the row has no button or if the first column is too narrow to draw it
+     */
+    wxRect GetButtonRect() const;
+    wxRect GetCheckboxRect(size_t col = 0) const;
+    wxRect GetChoiceRect(size_t col = 0) const;
+    /**
+     * @brief compute the layout of cell 'col' when the row is drawn in 'rowRect': the checkbox and the drop down
+     * arrow rects (empty when the cell has none). Returns false if the cell is too narrow to draw its content
+     */
+    bool GetCellLayout(size_t col, const wxRect& rowRect, wxRect& checkboxRect, wxRect& dropDownRect) const;
 
     void AddChild(clRowEntry* child);
 
+    /**
+     * @brief add new items (without children) to this item, the items are linked in one pass. If 'lessThan' is set,
+     * the new items (sorted by 'lessThan') are merged into the sorted children, otherwise they are appended
+     */
+    void AddChildren(const clRowEntry::Vec_t& children,
+                     const std::function<bool(clRowEntry*, clRowEntry*)>& lessThan = nullptr);
+
     /**
      * @brief insert item at 'where'. The new item is placed after 'prev'
      */
     void InsertChild(clRowEntry* child, clRowEntry* prev);
 
+    /**
+     * @brief insert item at position 'index' of the children list
+     */
+    void InsertChildAt(clRowEntry* child, size_t index);
+
+    /**
+     * @brief insert new items (without children) at position 'index' of the children list, in a single pass
+     */
+    void InsertChildrenAt(const clRowEntry::Vec_t& children, size_t index);
+
     /**
      * @brief insert this node between first and second
      */
@@ -179,12 +292,28 @@ public:
 
     bool IsExpanded() const { return HasFlag(kNF_Expanded) || HasFlag(kNF_Hidden); }
     bool SetExpanded(bool b);
+    /**
+     * @brief expand (or collapse) this item and all its descendants in one pass over the subtree. Unlike SetExpanded,
+     * no event is fired
+     */
+    void SetSubtreeExpanded(bool b);
     bool IsRoot() const { return GetParent() == nullptr; }
     
     // Cell accessors
     void SetBitmapIndex(int bitmapIndex, size_t col = 0);
     void SetBitmapSelectedIndex(int bitmapIndex, size_t col = 0);
     void SetLabel(const wxString& label, size_t col = 0);
+    /**
+     * @brief keep a number or a time in a cell. The cell is formatted only when its text is needed
+     */
+    void SetValueInt64(wxLongLong_t value, size_t col = 0);
+    void SetValueDouble(double value, size_t col = 0);
+    void SetValueDateTime(const wxDateTime& value, size_t col = 0);
+    /**
+     * @brief replace the content of a cell, adding columns if needed
+     */
+    void SetCellValue(const clCellValue& value, size_t col = 0);
+    const clCellValue& GetCellValue(size_t col = 0) const { return GetColumn(col); }
     /**
      * @brief make this specific cell as "choice" (dropdown will drawn to the right)
      */
@@ -200,11 +329,28 @@ public:
     const wxString& GetLabel(size_t col = 0) const;
 
     const std::vector<clRowEntry*>& GetChildren() const { return m_children; }
-    std::vector<clRowEntry*>& GetChildren() { return m_children; }
+    /**
+     * @brief access the children in order to modify them (e.g. sort them). The selected rows ranges are converted and
+     * the children index is dropped first
+     */
+    std::vector<clRowEntry*>& GetChildrenForUpdate();
     wxTreeItemData* GetClientObject() const { return m_clientObject; }
     void SetParent(clRowEntry* parent);
     clRowEntry* GetParent() const { return m_parent; }
     bool HasChildren() const { return !m_children.empty(); }
+    /**
+     * @brief should an expand button be drawn for this row?
+     */
+    bool HasButton() const { return HasChildren() || HasFlag(kNF_VirtualChildren); }
+    /**
+     * @brief for rows bound to a virtual model item: draw the expand button in the given state, the row itself has no
+     * children
+     */
+    void SetVirtualButton(bool hasChildren, bool expanded)
+    {
+        SetFlag(kNF_VirtualChildren, hasChildren);
+        SetFlag(kNF_Expanded, expanded);
+    }
     void SetClientData(wxTreeItemData* clientData)
     {
         wxDELETE(m_clientObject);
@@ -212,13 +358,45 @@ public:
     }
     size_t GetChildrenCount(bool recurse) const;
     int GetExpandedLines() const;
+
+    /**
+     * @brief return the number of visible rows in this subtree (including this item)
+     */
+    size_t GetRowsCount() const { return m_rowsCount; }
+
+    /**
+     * @brief return the number of visible rows between the parent's first child and this item
+     */
+    size_t GetRowsOffsetInParent();
+    /**
+     * @brief return the position of this item in its parent's children list. For the parents with many children, this
+     * and GetRowsOffsetInParent are O(log n) even while the children are inserted or deleted
+     */
+    size_t GetIndexInParent();
+
+    /**
+     * @brief return the child that contains the row at 'offset' (relative to the first child)
+     * On return, 'offset' is updated to be relative to the returned child
+     */
+    clRowEntry* GetChildAtRowsOffset(size_t& offset);
     void GetNextItems(int count, clRowEntry::Vec_t& items, bool selfIncluded = true);
     void GetPrevItems(int count, clRowEntry::Vec_t& items, bool selfIncluded = true);
     void SetIndentsCount(int count) { this->m_indentsCount = count; }
     int GetIndentsCount() const { return m_indentsCount; }
 
-    bool IsSelected() const { return HasFlag(kNF_Selected); }
+    /**
+     * @brief is this item selected? Either on its own (see SetSelected) or as part of a selected rows range (see
+     * clTreeCtrlModel::SelectRange)
+     */
+    bool IsSelected() const;
     void SetSelected(bool b) { SetFlag(kNF_Selected, b); }
+    /**
+     * @brief was this item selected on its own (and not as part of a rows range)?
+     */
+    bool HasSelectionFlag() const { return HasFlag(kNF_Selected); }
+    /**
+     * @brief clear the selection of the whole tree
+     */
     void UnselectAll();
     bool IsSorted() const { return HasFlag(kNF_SortItems); }
 };
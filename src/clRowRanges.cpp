@@ -0,0 +1,129 @@
+#include "clRowRanges.h"
+#include <algorithm>
+#include <iterator>
+
+void clRowRanges::Add(size_t first, size_t last)
+{
+    // Merge with the ranges that overlap or touch [first, last]
+    Map_t::iterator iter = m_ranges.upper_bound(first);
+    if(iter != m_ranges.begin()) {
+        Map_t::iterator prev = std::prev(iter);
+        if(prev->second + 1 >= first) {
+            iter = prev;
+        }
+    }
+    while(iter != m_ranges.end() && iter->first <= last + 1) {
+        first = std::min(first, iter->first);
+        last = std::max(last, iter->second);
+        m_rowsCount -= (iter->second - iter->first + 1);
+        iter = m_ranges.erase(iter);
+    }
+    m_ranges.insert({ first, last });
+    m_rowsCount += (last - first + 1);
+}
+
+bool clRowRanges::Remove(size_t row)
+{
+    Map_t::iterator iter = m_ranges.upper_bound(row);
+    if(iter == m_ranges.begin()) {
+        return false;
+    }
+    --iter;
+    size_t first = iter->first;
+    size_t last = iter->second;
+    if(row > last) {
+        return false;
+    }
+    // Split the range around the row
+    m_ranges.erase(iter);
+    if(first < row) {
+        m_ranges.insert({ first, row - 1 });
+    }
+    if(row < last) {
+        m_ranges.insert({ row + 1, last });
+    }
+    --m_rowsCount;
+    return true;
+}
+
+bool clRowRanges::Contains(size_t row) const
+{
+    // The last range that starts at, or before, the row
+    Map_t::const_iterator iter = m_ranges.upper_bound(row);
+    if(iter == m_ranges.begin()) {
+        return false;
+    }
+    --iter;
+    return row <= iter->second;
+}
+
+void clRowRanges::InsertRows(size_t row, size_t count)
+{
+    if(count == 0) {
+        return;
+    }
+    Map_t ranges;
+    for(const Map_t::value_type& range : m_ranges) {
+        if(range.second < row) {
+            ranges.insert(range);
+        } else if(range.first >= row) {
+            ranges.insert({ range.first + count, range.second + count });
+        } else {
+            // The new rows split the range
+            ranges.insert({ range.first, row - 1 });
+            ranges.insert({ row + count, range.second + count });
+        }
+    }
+    m_ranges.swap(ranges);
+}
+
+void clRowRanges::RemoveRows(size_t row, size_t count)
+{
+    if(count == 0) {
+        return;
+    }
+    size_t end = (count > (size_t)-1 - row) ? (size_t)-1 : (row + count); // the first row after the removed rows
+    Map_t ranges;
+    m_rowsCount = 0;
+    for(const Map_t::value_type& range : m_ranges) {
+        // The part before the removed rows is kept, the part after them moves up
+        if(range.first < row) {
+            DoAppend(ranges, range.first, std::min(range.second, row - 1));
+        }
+        if(range.second >= end) {
+            DoAppend(ranges, std::max(range.first, end) - count, range.second - count);
+        }
+    }
+    m_ranges.swap(ranges);
+}
+
+void clRowRanges::DoAppend(Map_t& ranges, size_t first, size_t last)
+{
+    // Ranges that touch the last one are merged into it
+    if(!ranges.empty()) {
+        Map_t::iterator prev = std::prev(ranges.end());
+        if(prev->second + 1 == first) {
+            prev->second = last;
+            m_rowsCount += (last - first + 1);
+            return;
+        }
+    }
+    ranges.insert(ranges.end(), { first, last });
+    m_rowsCount += (last - first + 1);
+}
+
+void clRowRanges::Truncate(size_t rowsCount)
+{
+    Map_t::iterator iter = m_ranges.lower_bound(rowsCount);
+    for(Map_t::iterator it = iter; it != m_ranges.end(); ++it) {
+        m_rowsCount -= (it->second - it->first + 1);
+    }
+    m_ranges.erase(iter, m_ranges.end());
+    if(!m_ranges.empty()) {
+        Map_t::iterator last = std::prev(m_ranges.end());
+        if(last->second >= rowsCount) {
+            m_rowsCount -= (last->second - rowsCount + 1);
+            last->second = rowsCount - 1;
+        }
+    }
+}
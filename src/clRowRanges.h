@@ -0,0 +1,75 @@
+#ifndef CLROWRANGES_H
+#define CLROWRANGES_H
+
+#include "codelite_exports.h"
+#include <cstddef>
+#include <map>
+#include <utility>
+
+/**
+ * @brief a set of rows stored as sorted, non overlapping ranges (first row -> last row, inclusive). Adding a range of
+ * rows or testing a row costs O(log(ranges)) no matter how many rows the ranges hold
+ */
+class WXDLLIMPEXP_SDK clRowRanges
+{
+public:
+    typedef std::map<size_t, size_t> Map_t;
+    typedef Map_t::const_iterator const_iterator;
+
+protected:
+    Map_t m_ranges;
+    size_t m_rowsCount = 0; // the number of rows in all the ranges
+
+    /**
+     * @brief append [first, last] after the last range of 'ranges' and count its rows
+     */
+    void DoAppend(Map_t& ranges, size_t first, size_t last);
+
+public:
+    /**
+     * @brief add the rows 'first' to 'last' (inclusive), merging with the ranges that overlap or touch them
+     */
+    void Add(size_t first, size_t last);
+    /**
+     * @brief remove a single row. Return true if the row was in one of the ranges
+     */
+    bool Remove(size_t row);
+    bool Contains(size_t row) const;
+    /**
+     * @brief 'count' rows were inserted at 'row': the rows from 'row' onward move down. The new rows are not added
+     */
+    void InsertRows(size_t row, size_t count);
+    /**
+     * @brief the rows 'row' to 'row + count - 1' were removed: drop them and move the rows after them up
+     */
+    void RemoveRows(size_t row, size_t count);
+    /**
+     * @brief drop the rows from 'rowsCount' onward
+     */
+    void Truncate(size_t rowsCount);
+
+    void Clear()
+    {
+        m_ranges.clear();
+        m_rowsCount = 0;
+    }
+    bool IsEmpty() const { return m_ranges.empty(); }
+    /**
+     * @brief the number of rows (not ranges)
+     */
+    size_t GetRowsCount() const { return m_rowsCount; }
+    /**
+     * @brief the first row. Must not be called when IsEmpty()
+     */
+    size_t GetFirstRow() const { return m_ranges.begin()->first; }
+    void Swap(clRowRanges& other)
+    {
+        m_ranges.swap(other.m_ranges);
+        std::swap(m_rowsCount, other.m_rowsCount);
+    }
+
+    const_iterator begin() const { return m_ranges.begin(); }
+    const_iterator end() const { return m_ranges.end(); }
+};
+
+#endif // CLROWRANGES_H
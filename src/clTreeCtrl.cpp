@@ -8,6 +8,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <wx/app.h>
+#include <wx/dataview.h>
 #include <wx/dcbuffer.h>
 #include <wx/dcgraph.h>
 #include <wx/dcmemory.h>
@@ -35,6 +36,12 @@
 
 wxDEFINE_EVENT(wxEVT_TREE_ITEM_VALUE_CHANGED, wxTreeEvent);
 wxDEFINE_EVENT(wxEVT_TREE_CHOICE, wxTreeEvent);
+wxDEFINE_EVENT(wxEVT_TREE_ITEMS_SELECTION_CHANGED, clTreeItemsEvent);
+wxDEFINE_EVENT(wxEVT_TREE_ITEMS_DELETED, clTreeItemsEvent);
+wxDEFINE_EVENT(wxEVT_TREE_EXPANDING_ALL, wxTreeEvent);
+wxDEFINE_EVENT(wxEVT_TREE_EXPANDED_ALL, wxTreeEvent);
+wxDEFINE_EVENT(wxEVT_TREE_COLLAPSING_ALL, wxTreeEvent);
+wxDEFINE_EVENT(wxEVT_TREE_COLLAPSED_ALL, wxTreeEvent);
 
 namespace
 {
@@ -118,12 +125,12 @@ void clTreeCtrl::UpdateLineHeight()
 void clTreeCtrl::DoInitialize()
 {
     UpdateLineHeight();
-    Bind(wxEVT_IDLE, &clTreeCtrl::OnIdle, this);
     Bind(wxEVT_PAINT, &clTreeCtrl::OnPaint, this);
     Bind(wxEVT_ERASE_BACKGROUND, [&](wxEraseEvent& event) { wxUnusedVar(event); });
     Bind(wxEVT_LEFT_DOWN, &clTreeCtrl::OnMouseLeftDown, this);
     Bind(wxEVT_LEFT_UP, &clTreeCtrl::OnMouseLeftUp, this);
     Bind(wxEVT_LEFT_DCLICK, &clTreeCtrl::OnMouseLeftDClick, this);
+    Bind(wxEVT_MOTION, &clTreeCtrl::OnMouseMotion, this);
     Bind(wxEVT_LEAVE_WINDOW, &clTreeCtrl::OnLeaveWindow, this);
     Bind(wxEVT_ENTER_WINDOW, &clTreeCtrl::OnEnterWindow, this);
     Bind(wxEVT_CONTEXT_MENU, &clTreeCtrl::OnContextMenu, this);
@@ -140,12 +147,12 @@ void clTreeCtrl::DoInitialize()
 
 clTreeCtrl::~clTreeCtrl()
 {
-    Unbind(wxEVT_IDLE, &clTreeCtrl::OnIdle, this);
     Unbind(wxEVT_PAINT, &clTreeCtrl::OnPaint, this);
     Unbind(wxEVT_ERASE_BACKGROUND, [&](wxEraseEvent& event) { wxUnusedVar(event); });
     Unbind(wxEVT_LEFT_DOWN, &clTreeCtrl::OnMouseLeftDown, this);
     Unbind(wxEVT_LEFT_UP, &clTreeCtrl::OnMouseLeftUp, this);
     Unbind(wxEVT_LEFT_DCLICK, &clTreeCtrl::OnMouseLeftDClick, this);
+    Unbind(wxEVT_MOTION, &clTreeCtrl::OnMouseMotion, this);
     Unbind(wxEVT_LEAVE_WINDOW, &clTreeCtrl::OnLeaveWindow, this);
     Unbind(wxEVT_ENTER_WINDOW, &clTreeCtrl::OnEnterWindow, this);
     Unbind(wxEVT_CONTEXT_MENU, &clTreeCtrl::OnContextMenu, this);
@@ -170,6 +177,10 @@ void clTreeCtrl::OnPaint(wxPaintEvent& event)
     // Call the parent's Render method
     Render(dc);
 
+    if(DoPaintRows(dc)) {
+        return;
+    }
+
     if(!m_model.GetRoot()) {
         // Reset the various items
         SetFirstItemOnScreen(nullptr);
@@ -241,19 +252,27 @@ void clTreeCtrl::OnPaint(wxPaintEvent& event)
     SetFirstItemOnScreen(firstItem);
 
     // Draw the items
+    clRowEntry::Vec_t::iterator firstVisible =
+        std::find_if(items.begin(), items.end(), [](clRowEntry* item) { return !item->IsHidden(); });
+    DoRenderRows(dc, items, (firstVisible == items.end()) ? 0 : m_model.GetItemIndex(*firstVisible));
+    if(needToUpdateScrollbar) {
+        CallAfter(&clTreeCtrl::UpdateScrollBar);
+    }
+}
+
+void clTreeCtrl::DoRenderRows(wxDC& dc, const clRowEntry::Vec_t& items, int firstRow)
+{
     wxRect clientRect = GetItemsRect();
-    // Set the width of the clipping region to match the header's width
+    // The borders are drawn in logical coordinates, i.e. shifted by the horizontal scroll position
     clientRect.SetWidth(clientRect.GetWidth() + m_firstColumn + 1);
-    dc.SetClippingRegion(clientRect);
-    RenderItems(dc, items);
-    dc.DestroyClippingRegion();
+    // Zebra colouring and custom renderers depend on the row position on screen
+    bool stripes = HasStyle(wxTR_ROW_LINES) || HasStyle(wxDV_ROW_LINES) || m_customRenderer;
+    RenderItemsBuffered(dc, items, firstRow, stripes);
 
     // Keep the visible items
     m_model.SetOnScreenItems(items); // Keep track of the visible items
-    if(needToUpdateScrollbar) {
-        CallAfter(&clTreeCtrl::UpdateScrollBar);
-    }
-
+    // After a scroll (wheel, keyboard, ScrollToRow) or an expand, another row may be under the (still) mouse
+    DoUpdateHoveredRow();
     // Update the header as well
     if(GetHeader() && GetHeader()->IsShown()) {
         GetHeader()->Update();
@@ -284,13 +303,39 @@ void clTreeCtrl::OnPaint(wxPaintEvent& event)
     dc.DrawLine(pt1, pt2);
 }
 
+wxDC& clTreeCtrl::DoPrepareRowsBufferDC(wxMemoryDC& memDC, wxGCDC& gcdc)
+{
+#ifdef __WXMSW__
+    return CreateGCDC(memDC, gcdc, m_renderer);
+#else
+    return clControlWithItems::DoPrepareRowsBufferDC(memDC, gcdc);
+#endif
+}
+
+void clTreeCtrl::DoGetVirtualSlots(size_t count, clRowEntry::Vec_t& slots)
+{
+    // The slots are children of the root. They are bound to the visible items on every paint so their number depends
+    // on the view size only
+    clRowEntry* root = m_model.GetRoot();
+    if(!root) {
+        return;
+    }
+    while(root->GetChildrenCount(false) < count) {
+        m_model.AppendItem(m_model.GetRootItem(), "", -1, -1, nullptr);
+    }
+    const clRowEntry::Vec_t& children = root->GetChildren();
+    slots.insert(slots.end(), children.begin(), children.begin() + count);
+}
+
 wxTreeItemId clTreeCtrl::InsertItem(const wxTreeItemId& parent, const wxTreeItemId& previous, const wxString& text,
                                     int image, int selImage, wxTreeItemData* data)
 {
     wxTreeItemId item = m_model.InsertItem(parent, previous, text, image, selImage, data);
     DoUpdateHeader(item);
     if(IsExpanded(parent)) {
+        // The rows below the new item move, the rows back buffer is outdated
         UpdateScrollBar();
+        Refresh();
     }
     return item;
 }
@@ -301,11 +346,39 @@ wxTreeItemId clTreeCtrl::AppendItem(const wxTreeItemId& parent, const wxString&
     wxTreeItemId item = m_model.AppendItem(parent, text, image, selImage, data);
     DoUpdateHeader(item);
     if(IsExpanded(parent)) {
+        // The rows below the new item move, the rows back buffer is outdated
         UpdateScrollBar();
+        Refresh();
     }
     return item;
 }
 
+void clTreeCtrl::AppendItems(const wxTreeItemId& parent, const std::vector<clTreeItemInfo>& items,
+                             wxArrayTreeItemIds* ids)
+{
+    clRowEntry::Vec_t rows;
+    m_model.AppendItems(parent, items, rows);
+    if(rows.empty()) {
+        return;
+    }
+    if(ids) {
+        for(clRowEntry* row : rows) {
+            ids->Add(wxTreeItemId(row));
+        }
+    }
+    clControlWithItems::DoUpdateHeader(rows);
+    if(IsExpanded(parent)) {
+        UpdateScrollBar();
+        Refresh();
+    }
+}
+
+void clTreeCtrl::SortChildren(const wxTreeItemId& item, bool threadSafeSortFunction)
+{
+    m_model.SortChildren(item, threadSafeSortFunction);
+    Refresh();
+}
+
 wxTreeItemId clTreeCtrl::AddRoot(const wxString& text, int image, int selImage, wxTreeItemData* data)
 {
     wxTreeItemId root = m_model.AddRoot(text, image, selImage, data);
@@ -313,11 +386,25 @@ wxTreeItemId clTreeCtrl::AddRoot(const wxString& text, int image, int selImage,
     return root;
 }
 
-wxTreeItemId clTreeCtrl::GetRootItem() const { return m_model.GetRootItem(); }
+wxTreeItemId clTreeCtrl::GetRootItem() const
+{
+    if(IsVirtual()) {
+        // the virtual root
+        return wxTreeItemId();
+    }
+    return m_model.GetRootItem();
+}
 
 void clTreeCtrl::Expand(const wxTreeItemId& item)
 {
     CHECK_ITEM_RET(item);
+    if(IsVirtual()) {
+        if(DoVirtualSetExpanded(item, true)) {
+            UpdateScrollBar();
+            Refresh();
+        }
+        return;
+    }
     clRowEntry* child = m_model.ToPtr(item);
     if(!child)
         return;
@@ -334,6 +421,13 @@ void clTreeCtrl::Expand(const wxTreeItemId& item)
 void clTreeCtrl::Collapse(const wxTreeItemId& item)
 {
     CHECK_ITEM_RET(item);
+    if(IsVirtual()) {
+        if(DoVirtualSetExpanded(item, false)) {
+            UpdateScrollBar();
+            Refresh();
+        }
+        return;
+    }
     clRowEntry* child = m_model.ToPtr(item);
     if(!child)
         return;
@@ -347,22 +441,38 @@ void clTreeCtrl::Collapse(const wxTreeItemId& item)
 void clTreeCtrl::SelectItem(const wxTreeItemId& item, bool select)
 {
     CHECK_ITEM_RET(item);
+    if(IsVirtual()) {
+        if(select) {
+            DoVirtualSelect(item, false, false);
+        } else if(IsSelected(item) && m_virtualSelection.Remove(m_virtualRows.GetRow(item))) {
+            NotifySelectionChanged();
+            SendVirtualEvent(wxEVT_TREE_SEL_CHANGED, item);
+        }
+        Refresh();
+        return;
+    }
     if((select && m_model.IsItemSelected(item)) || (!select && !m_model.IsItemSelected(item))) {
         return;
     }
+    clRowEntry::Vec_t selectedBefore = DoGetOnScreenSelection();
     m_model.SelectItem(item, select, false, true);
-    Refresh();
+    DoRefreshSelectionChanges(selectedBefore);
 }
 
 void clTreeCtrl::OnMouseLeftDown(wxMouseEvent& event)
 {
     event.Skip();
+    if(IsVirtual()) {
+        DoVirtualMouseLeftDown(event);
+        return;
+    }
     CHECK_ROOT_RET();
     int flags = 0;
     int column = wxNOT_FOUND;
     wxPoint pt = DoFixPoint(event.GetPosition());
     wxTreeItemId where = HitTest(pt, flags, column);
     if(where.IsOk()) {
+        clRowEntry::Vec_t selectedBefore = DoGetOnScreenSelection();
         if(flags & wxTREE_HITTEST_ONITEMBUTTON) {
             if(IsExpanded(where)) {
                 Collapse(where);
@@ -382,10 +492,7 @@ void clTreeCtrl::OnMouseLeftDown(wxMouseEvent& event)
                     m_model.SelectItem(where, !pNode->IsSelected(), true);
                 } else if(event.ShiftDown()) {
                     // Range selection
-                    clRowEntry::Vec_t range;
-                    m_model.GetRange(pNode, m_model.ToPtr(m_model.GetSingleSelection()), range);
-                    std::for_each(range.begin(), range.end(),
-                                  [&](clRowEntry* p) { m_model.AddSelection(wxTreeItemId(p)); });
+                    m_model.SelectRange(m_model.ToPtr(m_model.GetSingleSelection()), pNode);
                 } else {
                     // The default, single selection
                     if(!has_multiple_selection && pNode->IsSelected()) {
@@ -418,13 +525,16 @@ void clTreeCtrl::OnMouseLeftDown(wxMouseEvent& event)
                 GetEventHandler()->ProcessEvent(evt);
             }
         }
-        Refresh();
+        DoRefreshSelectionChanges(selectedBefore);
     }
 }
 
 void clTreeCtrl::OnMouseLeftUp(wxMouseEvent& event)
 {
     event.Skip();
+    if(IsVirtual()) {
+        return;
+    }
     int flags = 0;
     wxPoint pt = DoFixPoint(event.GetPosition());
     int column = wxNOT_FOUND;
@@ -434,74 +544,81 @@ void clTreeCtrl::OnMouseLeftUp(wxMouseEvent& event)
         clRowEntry* pNode = m_model.ToPtr(where);
         if(has_multiple_selection && pNode->IsSelected() && !event.HasAnyModifiers()) {
             // Select this item while clearing the others
+            clRowEntry::Vec_t selectedBefore = DoGetOnScreenSelection();
             m_model.SelectItem(where, true, false, true);
-            Refresh();
+            DoRefreshSelectionChanges(selectedBefore);
         }
     }
 }
 
 wxTreeItemId clTreeCtrl::HitTest(const wxPoint& point, int& flags, int& column) const
+{
+    wxTreeItemId where = DoHitTest(point, flags, column);
+    if(IsVirtual() && where.IsOk()) {
+        // report the item displayed by the row
+        return wxTreeItemId(wxUIntToPtr(m_model.ToPtr(where)->GetData()));
+    }
+    return where;
+}
+
+wxTreeItemId clTreeCtrl::DoHitTest(const wxPoint& point, int& flags, int& column) const
 {
     column = wxNOT_FOUND;
     flags = 0;
-    if(!m_model.GetRoot()) {
+    const clRowEntry::Vec_t& items = m_model.GetOnScreenItems();
+    if(!m_model.GetRoot() || items.empty()) {
         return wxTreeItemId();
     }
-    for(size_t i = 0; i < m_model.GetOnScreenItems().size(); ++i) {
-        const clRowEntry* item = m_model.GetOnScreenItems()[i];
-
-        {
-            wxRect buttonRect = item->GetButtonRect();
-            // Adjust the coordiantes incase we got h-scroll
-            buttonRect.SetX(buttonRect.GetX() - GetFirstColumn());
-            if(buttonRect.Contains(point)) {
-                flags = wxTREE_HITTEST_ONITEMBUTTON;
-                // The button is always on column 0
-                column = 0;
-                return wxTreeItemId(const_cast<clRowEntry*>(item));
-            }
-        }
-        if(item->GetItemRect().Contains(point)) {
-            flags = wxTREE_HITTEST_ONITEM;
-            if(GetHeader() && !GetHeader()->empty()) {
-                for(size_t col = 0; col < GetHeader()->size(); ++col) {
-                    // Check which column was clicked
-                    wxRect cellRect = item->GetCellRect(col);
-                    // We need to fix the x-axis to reflect any horizontal scrollbar
-                    cellRect.SetX(cellRect.GetX() - GetFirstColumn());
-                    if(cellRect.Contains(point)) {
-                        // Check if click was made on the checkbox ("state icon")
-                        wxRect checkboxRect = item->GetCheckboxRect(col);
-                        wxRect dropDownRect = item->GetChoiceRect(col);
-                        if(!checkboxRect.IsEmpty()) {
-                            // Adjust the coordiantes incase we got h-scroll
-                            checkboxRect.SetX(checkboxRect.GetX() - GetFirstColumn());
-                            if(checkboxRect.Contains(point)) {
-                                flags |= wxTREE_HITTEST_ONITEMSTATEICON;
-                            }
-                        } else if(!dropDownRect.IsEmpty()) {
-                            dropDownRect.SetX(dropDownRect.GetX() - GetFirstColumn());
-                            if(dropDownRect.Contains(point)) {
-                                flags |= wxTREE_HITTEST_ONDROPDOWNARROW;
-                            }
-                        }
-                        column = col;
-                        break;
-                    }
-                }
-                if(column == wxNOT_FOUND) {
-                    // assume its the last column (the last column expands on the remainder of the row
-                    column = (GetHeader()->size() - 1);
+
+    // The rows have a fixed height, so the row is found from the y coordinate
+    int index = GetOnScreenIndexAt(point.y);
+    if((index == wxNOT_FOUND) || ((size_t)index >= items.size())) {
+        return wxTreeItemId();
+    }
+    clRowEntry* item = items[index];
+    wxRect rowRect = GetRowRect(index);
+    if(!rowRect.Contains(point)) {
+        return wxTreeItemId();
+    }
+
+    // The rows parts are laid out in the columns coordinates, which include the horizontal scroll
+    wxPoint pt(point.x + GetFirstColumn(), point.y);
+    if(item->GetButtonRect().Contains(pt)) {
+        flags = wxTREE_HITTEST_ONITEMBUTTON;
+        // The button is always on column 0
+        column = 0;
+        return wxTreeItemId(item);
+    }
+
+    flags = wxTREE_HITTEST_ONITEM;
+    if(!GetHeader()->empty()) {
+        column = GetHeader()->HitColumn(pt.x);
+        // Check if click was made on the checkbox ("state icon") or on the drop down arrow
+        wxRect checkboxRect;
+        wxRect dropDownRect;
+        if(item->GetCellLayout(column, rowRect, checkboxRect, dropDownRect)) {
+            if(!checkboxRect.IsEmpty()) {
+                if(checkboxRect.Contains(pt)) {
+                    flags |= wxTREE_HITTEST_ONITEMSTATEICON;
                 }
+            } else if(dropDownRect.Contains(pt)) {
+                flags |= wxTREE_HITTEST_ONDROPDOWNARROW;
             }
-            return wxTreeItemId(const_cast<clRowEntry*>(item));
         }
     }
-    return wxTreeItemId();
+    return wxTreeItemId(item);
 }
 
 void clTreeCtrl::UnselectAll()
 {
+    if(IsVirtual()) {
+        if(!m_virtualSelection.IsEmpty()) {
+            m_virtualSelection.Clear();
+            NotifySelectionChanged();
+        }
+        Refresh();
+        return;
+    }
     if(!m_model.GetRoot()) {
         return;
     }
@@ -509,6 +626,30 @@ void clTreeCtrl::UnselectAll()
     Refresh();
 }
 
+void clTreeCtrl::SelectAll()
+{
+    if(!(GetTreeStyle() & wxTR_MULTIPLE)) {
+        // Can only be used with multiple selection trees
+        return;
+    }
+    if(IsVirtual()) {
+        if(GetRange() == 0) {
+            return;
+        }
+        // A single range, no matter how many rows
+        m_virtualSelection.Clear();
+        m_virtualSelection.Add(0, GetRange() - 1);
+        NotifySelectionChanged();
+        Refresh();
+        return;
+    }
+    if(!m_model.GetRoot()) {
+        return;
+    }
+    m_model.SelectAll();
+    Refresh();
+}
+
 wxPoint clTreeCtrl::DoFixPoint(const wxPoint& pt)
 {
     wxPoint point = pt;
@@ -520,6 +661,25 @@ void clTreeCtrl::EnsureVisible(const wxTreeItemId& item)
     if(!item.IsOk()) {
         return;
     }
+    if(IsVirtual()) {
+        // Expand the parents, starting from the top
+        std::vector<wxTreeItemId> parents;
+        for(wxTreeItemId p = m_virtualModel->GetParent(item); p.IsOk(); p = m_virtualModel->GetParent(p)) {
+            parents.insert(parents.begin(), p);
+        }
+        for(const wxTreeItemId& p : parents) {
+            if(!DoVirtualSetExpanded(p, true)) {
+                return;
+            }
+        }
+        int row = m_virtualRows.GetRow(item);
+        if(row != wxNOT_FOUND) {
+            DoVirtualEnsureRowVisible(row);
+        }
+        UpdateScrollBar();
+        Refresh();
+        return;
+    }
     // Make sure that all parents of ítem are expanded
     if(!m_model.ExpandToItem(item)) {
         return;
@@ -545,6 +705,67 @@ void clTreeCtrl::DoEnsureVisible(const wxTreeItemId& item)
     Refresh();
 }
 
+void clTreeCtrl::RefreshItem(const wxTreeItemId& item)
+{
+    CHECK_ITEM_RET(item);
+    if(IsVirtual()) {
+        int row = m_virtualRows.GetRow(item);
+        if(row != wxNOT_FOUND) {
+            DoRefreshRows(row, row);
+        }
+        return;
+    }
+    clRowEntry* row = m_model.ToPtr(item);
+    if(IsItemVisible(row)) {
+        DoRefreshRow(row);
+    } else if(row->IsVisible()) {
+        // The row was not drawn by the last paint but it may be on screen now (e.g. it was just added)
+        Refresh();
+    }
+}
+
+void clTreeCtrl::RefreshRange(const wxTreeItemId& from, const wxTreeItemId& to)
+{
+    CHECK_ITEM_RET(from);
+    CHECK_ITEM_RET(to);
+    int fromRow = wxNOT_FOUND;
+    int toRow = wxNOT_FOUND;
+    if(IsVirtual()) {
+        fromRow = m_virtualRows.GetRow(from);
+        toRow = m_virtualRows.GetRow(to);
+    } else if(m_model.ToPtr(from)->IsVisible() && m_model.ToPtr(to)->IsVisible()) {
+        fromRow = m_model.GetItemIndex(m_model.ToPtr(from));
+        toRow = m_model.GetItemIndex(m_model.ToPtr(to));
+    }
+    if((fromRow == wxNOT_FOUND) || (toRow == wxNOT_FOUND)) {
+        // The range is not made of visible rows
+        Refresh();
+        return;
+    }
+    DoRefreshRows(fromRow, toRow);
+}
+
+clRowEntry::Vec_t clTreeCtrl::DoGetOnScreenSelection() const
+{
+    clRowEntry::Vec_t selected;
+    for(clRowEntry* row : m_model.GetOnScreenItems()) {
+        if(row->IsSelected()) {
+            selected.push_back(row);
+        }
+    }
+    return selected;
+}
+
+void clTreeCtrl::DoRefreshSelectionChanges(const clRowEntry::Vec_t& selectedBefore)
+{
+    for(clRowEntry* row : m_model.GetOnScreenItems()) {
+        bool wasSelected = std::find(selectedBefore.begin(), selectedBefore.end(), row) != selectedBefore.end();
+        if(wasSelected != row->IsSelected()) {
+            DoRefreshRow(row);
+        }
+    }
+}
+
 void clTreeCtrl::OnMouseLeftDClick(wxMouseEvent& event)
 {
     event.Skip();
@@ -581,6 +802,9 @@ bool clTreeCtrl::IsExpanded(const wxTreeItemId& item) const
 {
     if(!item.GetID())
         return false;
+    if(IsVirtual()) {
+        return m_virtualRows.IsExpanded(item);
+    }
     clRowEntry* child = m_model.ToPtr(item);
     if(!child)
         return false;
@@ -591,6 +815,9 @@ bool clTreeCtrl::ItemHasChildren(const wxTreeItemId& item) const
 {
     if(!item.GetID())
         return false;
+    if(IsVirtual()) {
+        return m_virtualModel->HasChildren(item);
+    }
     clRowEntry* child = m_model.ToPtr(item);
     if(!child)
         return false;
@@ -606,7 +833,13 @@ void clTreeCtrl::SetIndent(int size)
 
 int clTreeCtrl::GetIndent() const { return m_model.GetIndentSize(); }
 
-bool clTreeCtrl::IsEmpty() const { return m_model.IsEmpty(); }
+bool clTreeCtrl::IsEmpty() const
+{
+    if(IsVirtual()) {
+        return m_virtualRows.GetRowsCount() == 0;
+    }
+    return m_model.IsEmpty();
+}
 
 size_t clTreeCtrl::GetChildrenCount(const wxTreeItemId& item, bool recursively) const
 {
@@ -630,7 +863,7 @@ wxTreeItemId clTreeCtrl::GetFirstChild(const wxTreeItemId& item, wxTreeItemIdVal
 {
     if(!item.GetID())
         return wxTreeItemId();
-    clRowEntry* node = m_model.ToPtr(item);
+    const clRowEntry* node = m_model.ToPtr(item);
     const clRowEntry::Vec_t& children = node->GetChildren();
     if(children.empty())
         return wxTreeItemId(); // No children
@@ -646,7 +879,7 @@ wxTreeItemId clTreeCtrl::GetNextChild(const wxTreeItemId& item, wxTreeItemIdValu
         return wxTreeItemId();
     int* pidx = (int*)&cookie;
     int& idx = (*pidx);
-    clRowEntry* node = m_model.ToPtr(item);
+    const clRowEntry* node = m_model.ToPtr(item);
     const clRowEntry::Vec_t& children = node->GetChildren();
     if(idx >= (int)children.size())
         return wxTreeItemId();
@@ -659,6 +892,11 @@ wxString clTreeCtrl::GetItemText(const wxTreeItemId& item, size_t col) const
 {
     if(!item.GetID())
         return "";
+    if(IsVirtual()) {
+        clCellValue cell("", -1, -1);
+        m_virtualModel->GetCellValue(item, col, cell);
+        return cell.GetValueString();
+    }
     clRowEntry* node = m_model.ToPtr(item);
     return node->GetLabel(col);
 }
@@ -673,6 +911,11 @@ wxTreeItemData* clTreeCtrl::GetItemData(const wxTreeItemId& item) const
 
 void clTreeCtrl::DoMouseScroll(const wxMouseEvent& event)
 {
+    if(IsVirtual()) {
+        clControlWithItems::DoMouseScroll(event);
+        UpdateScrollBar();
+        return;
+    }
     CHECK_ROOT_RET();
     if(!GetFirstItemOnScreen()) {
         return;
@@ -727,7 +970,7 @@ void clTreeCtrl::DoMouseScroll(const wxMouseEvent& event)
         SetFirstItemOnScreen(items.back()); // the last item
         UpdateScrollBar();
     }
-    Refresh();
+    RefreshAfterScroll();
 }
 
 void clTreeCtrl::DoBitmapAdded()
@@ -755,48 +998,56 @@ void clTreeCtrl::SetBitmaps(BitmapVec_t* bitmaps)
     Refresh();
 }
 
-void clTreeCtrl::ProcessIdle()
-{
-    if(HasStyle(wxTR_FULL_ROW_HIGHLIGHT)) {
-        CHECK_ROOT_RET();
-        int flags = 0;
-        wxPoint pt = ScreenToClient(::wxGetMousePosition());
-        int column = wxNOT_FOUND;
-        wxTreeItemId item = HitTest(pt, flags, column);
-        if(item.IsOk()) {
-            clRowEntry::Vec_t& items = m_model.GetOnScreenItems();
-            clRowEntry* hoveredNode = m_model.ToPtr(item);
-            bool refreshNeeded = false;
-            for(size_t i = 0; i < items.size(); ++i) {
-                bool new_state = hoveredNode == items[i];
-                bool old_state = items[i]->IsHovered();
-                if(!refreshNeeded) {
-                    refreshNeeded = (new_state != old_state);
-                }
-                items[i]->SetHovered(hoveredNode == items[i]);
-            }
-            if(refreshNeeded) {
-                Refresh();
-            }
-        }
-    }
+void clTreeCtrl::OnMouseMotion(wxMouseEvent& event)
+{
+    event.Skip();
+    m_mousePosition = DoFixPoint(event.GetPosition());
+    DoUpdateHoveredRow();
 }
 
 void clTreeCtrl::OnLeaveWindow(wxMouseEvent& event)
 {
     event.Skip();
+    m_mousePosition = wxDefaultPosition;
     CHECK_ROOT_RET();
-    clRowEntry::Vec_t& items = m_model.GetOnScreenItems();
-    for(size_t i = 0; i < items.size(); ++i) {
-        items[i]->SetHovered(false);
+    DoSetHoveredRow(nullptr);
+}
+
+void clTreeCtrl::DoUpdateHoveredRow()
+{
+    if(!HasStyle(wxTR_FULL_ROW_HIGHLIGHT) || (m_mousePosition == wxDefaultPosition)) {
+        return;
     }
-    Update();
+    CHECK_ROOT_RET();
+    int flags = 0;
+    int column = wxNOT_FOUND;
+    wxTreeItemId item = DoHitTest(m_mousePosition, flags, column);
+    DoSetHoveredRow(m_model.ToPtr(item));
+}
+
+void clTreeCtrl::DoSetHoveredRow(clRowEntry* row)
+{
+    clRowEntry* hovered = m_model.GetHoveredItem();
+    if(hovered == row) {
+        return;
+    }
+    if(hovered) {
+        hovered->SetHovered(false);
+        DoRefreshRow(hovered);
+    }
+    if(row) {
+        row->SetHovered(true);
+        DoRefreshRow(row);
+    }
+    m_model.SetHoveredItem(row);
 }
 
 void clTreeCtrl::ExpandAllChildren(const wxTreeItemId& item)
 {
     wxBusyCursor bc;
-    m_model.ExpandAllChildren(item);
+    if(!m_model.ExpandAllChildren(item)) {
+        return;
+    }
     UpdateScrollBar();
     DoUpdateHeader(item);
     Refresh();
@@ -805,7 +1056,9 @@ void clTreeCtrl::ExpandAllChildren(const wxTreeItemId& item)
 void clTreeCtrl::CollapseAllChildren(const wxTreeItemId& item)
 {
     wxBusyCursor bc;
-    m_model.CollapseAllChildren(item);
+    if(!m_model.CollapseAllChildren(item)) {
+        return;
+    }
     SetFirstItemOnScreen(m_model.ToPtr(item));
     SelectItem(item);
     UpdateScrollBar();
@@ -857,13 +1110,38 @@ wxTreeItemId clTreeCtrl::DoGetSiblingVisibleItem(const wxTreeItemId& item, bool
     return wxTreeItemId(*iter);
 }
 
-wxTreeItemId clTreeCtrl::GetSelection() const { return m_model.GetSingleSelection(); }
+wxTreeItemId clTreeCtrl::GetSelection() const
+{
+    if(IsVirtual()) {
+        if(m_virtualSelection.IsEmpty()) {
+            return wxTreeItemId();
+        }
+        return IsSelected(m_virtualFocusedItem) ? m_virtualFocusedItem
+                                                : m_virtualRows.GetItem(m_virtualSelection.GetFirstRow());
+    }
+    return m_model.GetSingleSelection();
+}
 
-wxTreeItemId clTreeCtrl::GetFocusedItem() const { return GetSelection(); }
+wxTreeItemId clTreeCtrl::GetFocusedItem() const
+{
+    if(IsVirtual()) {
+        return m_virtualFocusedItem;
+    }
+    return GetSelection();
+}
 
 size_t clTreeCtrl::GetSelections(wxArrayTreeItemIds& selections) const
 {
-    const clRowEntry::Vec_t& items = m_model.GetSelections();
+    if(IsVirtual()) {
+        for(const clRowRanges::const_iterator::value_type& range : m_virtualSelection) {
+            for(size_t row = range.first; row <= range.second; ++row) {
+                selections.Add(m_virtualRows.GetItem(row));
+            }
+        }
+        return selections.size();
+    }
+    clRowEntry::Vec_t items;
+    m_model.GetSelections(items);
     if(items.empty()) {
         return 0;
     }
@@ -882,6 +1160,10 @@ bool clTreeCtrl::DoKeyDown(const wxKeyEvent& event)
         return true;
     }
 
+    if(IsVirtual()) {
+        return DoVirtualKeyDown(event);
+    }
+
     // Let the parent process this
     if(clControlWithItems::DoKeyDown(event)) {
         return false;
@@ -928,15 +1210,12 @@ bool clTreeCtrl::DoKeyDown(const wxKeyEvent& event)
 
 bool clTreeCtrl::IsItemVisible(clRowEntry* item) const
 {
-    const clRowEntry::Vec_t& onScreenItems = m_model.GetOnScreenItems();
-    clRowEntry::Vec_t::const_iterator iter =
-        std::find_if(onScreenItems.begin(), onScreenItems.end(), [&](clRowEntry* p) { return p == item; });
-    return (iter != onScreenItems.end());
+    return m_model.IsOnScreen(item);
 }
 
 bool clTreeCtrl::IsItemFullyVisible(clRowEntry* item) const
 {
-    const wxRect& itemRect = item->GetItemRect();
+    wxRect itemRect = item->GetItemRect();
     wxRect clientRect = GetItemsRect();
     // since we mainly ensure visibility on the Y axis, we need to make sure that the client rect
     // has the same width as the item rect (incase of scrollbars, item rect will be wider)
@@ -995,7 +1274,7 @@ void clTreeCtrl::SetItemBackgroundColour(const wxTreeItemId& item, const wxColou
     clRowEntry* node = m_model.ToPtr(item);
     CHECK_PTR_RET(node);
     node->SetBgColour(colour, col);
-    Refresh();
+    RefreshItem(item);
 }
 
 wxColour clTreeCtrl::GetItemBackgroundColour(const wxTreeItemId& item, size_t col) const
@@ -1012,7 +1291,7 @@ void clTreeCtrl::SetItemTextColour(const wxTreeItemId& item, const wxColour& col
     clRowEntry* node = m_model.ToPtr(item);
     CHECK_PTR_RET(node);
     node->SetTextColour(colour, col);
-    Refresh();
+    RefreshItem(item);
 }
 
 wxColour clTreeCtrl::GetItemTextColour(const wxTreeItemId& item, size_t col) const
@@ -1030,7 +1309,7 @@ void clTreeCtrl::SetItemText(const wxTreeItemId& item, const wxString& text, siz
     CHECK_PTR_RET(node);
     node->SetLabel(text, col);
     DoUpdateHeader(item);
-    Refresh();
+    RefreshItem(item);
 }
 
 void clTreeCtrl::SetItemBold(const wxTreeItemId& item, bool bold, size_t col)
@@ -1046,7 +1325,7 @@ void clTreeCtrl::SetItemBold(const wxTreeItemId& item, bool bold, size_t col)
 
     // Changing font can change the width of the text, so update the header if needed
     DoUpdateHeader(item);
-    Refresh();
+    RefreshItem(item);
 }
 
 void clTreeCtrl::SetItemFont(const wxTreeItemId& item, const wxFont& font, size_t col)
@@ -1054,7 +1333,7 @@ void clTreeCtrl::SetItemFont(const wxTreeItemId& item, const wxFont& font, size_
     clRowEntry* node = m_model.ToPtr(item);
     CHECK_PTR_RET(node);
     node->SetFont(font, col);
-    Refresh();
+    RefreshItem(item);
 }
 
 wxFont clTreeCtrl::GetItemFont(const wxTreeItemId& item, size_t col) const
@@ -1112,6 +1391,14 @@ void clTreeCtrl::SetFirstItemOnScreen(clRowEntry* item) { m_model.SetFirstItemOn
 void clTreeCtrl::SetSortFunction(const clSortFunc_t& CompareFunc) { m_model.SetSortFunction(CompareFunc); }
 void clTreeCtrl::ScrollToRow(int firstLine)
 {
+    if(IsVirtual()) {
+        m_virtualFirstRow = wxMin((size_t)wxMax(firstLine, 0), DoGetVirtualMaxFirstRow(GetRange()));
+#if CL_USE_NATIVE_SCROLLBAR
+        UpdateScrollBar();
+#endif
+        RefreshAfterScroll();
+        return;
+    }
     clRowEntry* newTopLine = nullptr;
     // Thumbtrack sends the top-line index in event.GetPosition()
     newTopLine = m_model.GetItemFromIndex(firstLine);
@@ -1138,7 +1425,7 @@ void clTreeCtrl::ScrollToRow(int firstLine)
 #if CL_USE_NATIVE_SCROLLBAR
     UpdateScrollBar();
 #endif
-    Refresh();
+    RefreshAfterScroll();
 #ifndef __WXGTK3__
     wxYieldIfNeeded();
 #endif
@@ -1146,6 +1433,31 @@ void clTreeCtrl::ScrollToRow(int firstLine)
 
 void clTreeCtrl::ScrollRows(int steps, wxDirection direction)
 {
+    if(IsVirtual()) {
+        size_t count = m_virtualRows.GetRowsCount();
+        if(count == 0) {
+            return;
+        }
+        size_t row = 0;
+        if(steps == 0) {
+            // Top or Bottom
+            row = (direction == wxUP) ? 0 : (count - 1);
+        } else {
+            int focusedRow = m_virtualRows.GetRow(m_virtualFocusedItem);
+            size_t current = (focusedRow == wxNOT_FOUND) ? m_virtualFirstRow : focusedRow;
+            if(direction == wxUP) {
+                row = (current > (size_t)steps) ? (current - steps) : 0;
+            } else {
+                row = wxMin(current + steps, count - 1);
+            }
+        }
+        DoVirtualSelect(m_virtualRows.GetItem(row), false, ::wxGetKeyState(WXK_SHIFT));
+        DoVirtualEnsureRowVisible(row);
+        Refresh();
+        UpdateScrollBar();
+        return;
+    }
+
     // Process the rest of the scrolling events here
     wxTreeItemId nextSelection;
     bool fromTop = false;
@@ -1276,6 +1588,9 @@ void clTreeCtrl::EnableStyle(int style, bool enable, bool refresh)
 wxTreeItemId clTreeCtrl::GetItemParent(const wxTreeItemId& item) const
 {
     CHECK_ITEM_RET_INVALID_ITEM(item);
+    if(IsVirtual()) {
+        return m_virtualModel->GetParent(item);
+    }
     return wxTreeItemId(m_model.ToPtr(item)->GetParent());
 }
 
@@ -1285,7 +1600,7 @@ void clTreeCtrl::SetItemImage(const wxTreeItemId& item, int imageId, int openIma
     CHECK_PTR_RET(node);
     node->SetBitmapIndex(imageId, col);
     node->SetBitmapSelectedIndex(openImageId, col);
-    Refresh();
+    RefreshItem(item);
 }
 
 int clTreeCtrl::GetItemImage(const wxTreeItemId& item, bool selectedImage, size_t col) const
@@ -1303,7 +1618,17 @@ void clTreeCtrl::DoUpdateHeader(const wxTreeItemId& item) { clControlWithItems::
 
 bool clTreeCtrl::IsVisible(const wxTreeItemId& item) const { return m_model.IsVisible(item); }
 
-bool clTreeCtrl::IsSelected(const wxTreeItemId& item) const { return m_model.IsItemSelected(item); }
+bool clTreeCtrl::IsSelected(const wxTreeItemId& item) const
+{
+    if(IsVirtual()) {
+        if(!item.IsOk() || m_virtualSelection.IsEmpty()) {
+            return false;
+        }
+        int row = m_virtualRows.GetRow(item);
+        return (row != wxNOT_FOUND) && m_virtualSelection.Contains(row);
+    }
+    return m_model.IsItemSelected(item);
+}
 
 wxTreeItemId clTreeCtrl::GetRow(const wxPoint& pt) const
 {
@@ -1315,15 +1640,40 @@ wxTreeItemId clTreeCtrl::GetRow(const wxPoint& pt) const
     }
     return wxTreeItemId();
 }
-int clTreeCtrl::GetFirstItemPosition() const { return m_model.GetItemIndex(m_model.GetFirstItemOnScreen()); }
+int clTreeCtrl::GetFirstItemPosition() const
+{
+    if(IsVirtual()) {
+        return m_virtualFirstRow;
+    }
+    return m_model.GetItemIndex(m_model.GetFirstItemOnScreen());
+}
 
-int clTreeCtrl::GetRange() const { return m_model.GetExpandedLines(); }
+int clTreeCtrl::GetRange() const
+{
+    if(IsVirtual()) {
+        return m_virtualRows.GetRowsCount();
+    }
+    return m_model.GetExpandedLines();
+}
 
 void clTreeCtrl::DeleteAllItems()
 {
+    if(m_model.GetSelectionsCount() != 0 || !m_virtualSelection.IsEmpty()) {
+        NotifySelectionChanged();
+    }
     m_model.EnableEvents(false);
-    Delete(GetRootItem());
+    Delete(m_model.GetRootItem());
     m_model.EnableEvents(true);
+    // start over with all the virtual items collapsed
+    m_virtualRows.Reset(m_virtualModel);
+    m_virtualFirstRow = 0;
+    m_virtualFocusedItem = wxTreeItemId();
+    m_virtualAnchorItem = wxTreeItemId();
+    m_virtualSelection.Clear();
+    if(IsVirtual()) {
+        // The root holds the rows used for drawing
+        m_model.AddRoot("", -1, -1, nullptr);
+    }
     DoUpdateHeader(nullptr);
     m_scrollLines = 0;
     SetFirstColumn(0);
@@ -1351,6 +1701,7 @@ void clTreeCtrl::HighlightText(const wxTreeItemId& item, bool b)
         return;
     }
     m_model.ToPtr(item)->SetHighlight(b);
+    RefreshItem(item);
 }
 
 void clTreeCtrl::ClearHighlight(const wxTreeItemId& item)
@@ -1361,7 +1712,7 @@ void clTreeCtrl::ClearHighlight(const wxTreeItemId& item)
     clRowEntry* row = m_model.ToPtr(item);
     row->SetHighlight(false);
     row->SetHighlightInfo({});
-    Refresh();
+    RefreshItem(item);
 }
 
 clRowEntry* clTreeCtrl::DoFind(clRowEntry* from, const wxString& what, size_t col, size_t searchFlags, bool next)
@@ -1441,7 +1792,7 @@ void clTreeCtrl::Check(const wxTreeItemId& item, bool check, size_t col)
     evt.SetEventObject(this);
     evt.SetItem(item);
     GetEventHandler()->ProcessEvent(evt);
-    Refresh();
+    RefreshItem(item);
 }
 
 bool clTreeCtrl::IsChecked(const wxTreeItemId& item, size_t col) const
@@ -1488,3 +1839,328 @@ void clTreeCtrl::Commit()
     m_model.SetSortFunction(m_oldSortFunc);
     Refresh();
 }
+
+void clTreeCtrl::SetVirtualModel(clTreeCtrlVirtualModel* model)
+{
+    // Switching modes removes the items of the current mode
+    m_virtualModel = model;
+    DeleteAllItems();
+}
+
+void clTreeCtrl::RefreshVirtualItems()
+{
+    if(!IsVirtual()) {
+        return;
+    }
+    m_virtualRows.Refresh();
+
+    // Forget about items that are no longer visible
+    size_t selected = m_virtualSelection.GetRowsCount();
+    m_virtualSelection.Truncate(m_virtualRows.GetRowsCount());
+    if(m_virtualSelection.GetRowsCount() != selected) {
+        NotifySelectionChanged();
+    }
+    if(m_virtualRows.GetRow(m_virtualFocusedItem) == wxNOT_FOUND) {
+        m_virtualFocusedItem = wxTreeItemId();
+    }
+    if(m_virtualRows.GetRow(m_virtualAnchorItem) == wxNOT_FOUND) {
+        m_virtualAnchorItem = wxTreeItemId();
+    }
+    m_virtualFirstRow = wxMin(m_virtualFirstRow, DoGetVirtualMaxFirstRow(m_virtualRows.GetRowsCount()));
+    UpdateScrollBar();
+    Refresh();
+}
+
+bool clTreeCtrl::DoPaintRows(wxDC& dc)
+{
+    if(!IsVirtual()) {
+        return false;
+    }
+
+    // The rows count might have changed since the last paint
+    size_t count = m_virtualRows.GetRowsCount();
+    m_virtualFirstRow = wxMin(m_virtualFirstRow, DoGetVirtualMaxFirstRow(count));
+    size_t maxItems = wxMax(GetNumLineCanFitOnScreen(), 0);
+    size_t visibleRows = (m_virtualFirstRow < count) ? wxMin(maxItems, count - m_virtualFirstRow) : 0;
+
+    clRowEntry::Vec_t items;
+    items.reserve(visibleRows);
+    DoGetVirtualSlots(visibleRows, items);
+
+    size_t columnsCount = GetHeader()->empty() ? 1 : GetHeader()->size();
+    for(size_t i = 0; i < items.size(); ++i) {
+        int depth = 0;
+        wxTreeItemId item = m_virtualRows.GetItem(m_virtualFirstRow + i, &depth);
+        clRowEntry* slot = items[i];
+        slot->SetData((wxUIntPtr)item.GetID());
+        // Like the top level items of a tree with a hidden root
+        slot->SetIndentsCount(depth + 1);
+        slot->SetVirtualButton(m_virtualModel->HasChildren(item), m_virtualRows.IsExpanded(item));
+        slot->SetSelected(m_virtualSelection.Contains(m_virtualFirstRow + i));
+        for(size_t col = 0; col < columnsCount; ++col) {
+            clCellValue cell("", -1, -1);
+            m_virtualModel->GetCellValue(item, col, cell);
+            slot->SetCellValue(cell, col);
+        }
+        clControlWithItems::DoUpdateHeader(slot);
+    }
+    SetFirstItemOnScreen(items.empty() ? nullptr : items[0]);
+    DoRenderRows(dc, items, m_virtualFirstRow);
+    return true;
+}
+
+size_t clTreeCtrl::DoGetVirtualMaxFirstRow(size_t count) const
+{
+    // The last row should be fully visible when scrolled to the bottom
+    size_t fullyVisible = wxMax(GetNumLineCanFitOnScreen(true), 0);
+    return (count > fullyVisible) ? (count - fullyVisible) : 0;
+}
+
+void clTreeCtrl::DoVirtualEnsureRowVisible(size_t row)
+{
+    size_t fullyVisible = wxMax(GetNumLineCanFitOnScreen(true), 1);
+    if(row < m_virtualFirstRow) {
+        m_virtualFirstRow = row;
+    } else if(row >= (m_virtualFirstRow + fullyVisible)) {
+        m_virtualFirstRow = row - fullyVisible + 1;
+    }
+}
+
+void clTreeCtrl::DoVirtualSelect(const wxTreeItemId& item, bool ctrlDown, bool shiftDown)
+{
+    if(!item.IsOk()) {
+        return;
+    }
+    bool multiple = HasStyle(wxTR_MULTIPLE);
+    int anchorRow = m_virtualRows.GetRow(m_virtualAnchorItem);
+    int row = m_virtualRows.GetRow(item);
+    if(multiple && ctrlDown) {
+        // Toggle the selection
+        if(row != wxNOT_FOUND && !m_virtualSelection.Remove(row)) {
+            m_virtualSelection.Add(row, row);
+        }
+        m_virtualAnchorItem = item;
+    } else if(multiple && shiftDown && (anchorRow != wxNOT_FOUND) && (row != wxNOT_FOUND)) {
+        // Range selection
+        m_virtualSelection.Add(wxMin(anchorRow, row), wxMax(anchorRow, row));
+    } else {
+        // The default, single selection
+        m_virtualFocusedItem = item;
+        m_virtualAnchorItem = item;
+        if(row == wxNOT_FOUND) {
+            return;
+        }
+        if(m_virtualSelection.GetRowsCount() == 1 && m_virtualSelection.GetFirstRow() == (size_t)row) {
+            return;
+        }
+        m_virtualSelection.Clear();
+        m_virtualSelection.Add(row, row);
+    }
+    m_virtualFocusedItem = item;
+    NotifySelectionChanged();
+    SendVirtualEvent(wxEVT_TREE_SEL_CHANGED, item);
+}
+
+bool clTreeCtrl::DoVirtualSetExpanded(const wxTreeItemId& item, bool expand)
+{
+    if(m_virtualRows.IsExpanded(item) == expand) {
+        return true;
+    }
+    if(expand && !m_virtualModel->HasChildren(item)) {
+        return false;
+    }
+    // Give the user a chance to veto this
+    if(!SendVirtualEvent(expand ? wxEVT_TREE_ITEM_EXPANDING : wxEVT_TREE_ITEM_COLLAPSING, item)) {
+        return false;
+    }
+    int row = m_virtualRows.GetRow(item);
+    size_t count = m_virtualRows.GetRowsCount();
+    if(!(expand ? m_virtualRows.Expand(item) : m_virtualRows.Collapse(item))) {
+        return false;
+    }
+    if(row != wxNOT_FOUND) {
+        // The selection is kept by row: move the selected rows below the item. The rows of a collapsed item are no
+        // longer selected
+        size_t selected = m_virtualSelection.GetRowsCount();
+        if(expand) {
+            m_virtualSelection.InsertRows(row + 1, m_virtualRows.GetRowsCount() - count);
+        } else {
+            m_virtualSelection.RemoveRows(row + 1, count - m_virtualRows.GetRowsCount());
+        }
+        if(m_virtualSelection.GetRowsCount() != selected) {
+            NotifySelectionChanged();
+        }
+    }
+    if(!expand) {
+        // The first row might now be beyond the end
+        m_virtualFirstRow = wxMin(m_virtualFirstRow, DoGetVirtualMaxFirstRow(m_virtualRows.GetRowsCount()));
+    }
+    SendVirtualEvent(expand ? wxEVT_TREE_ITEM_EXPANDED : wxEVT_TREE_ITEM_COLLAPSED, item);
+    return true;
+}
+
+bool clTreeCtrl::DoVirtualKeyDown(const wxKeyEvent& event)
+{
+    wxTreeItemId item = m_virtualFocusedItem;
+    if(!item.IsOk()) {
+        // Let clScrolledPanel handle the navigation keys
+        return false;
+    }
+
+    switch(event.GetKeyCode()) {
+    case WXK_LEFT:
+    case WXK_NUMPAD_LEFT:
+        if(IsExpanded(item)) {
+            Collapse(item);
+        } else if(m_virtualModel->GetParent(item).IsOk()) {
+            wxTreeItemId parent = m_virtualModel->GetParent(item);
+            DoVirtualSelect(parent, false, false);
+            EnsureVisible(parent);
+        }
+        return true;
+    case WXK_RIGHT:
+    case WXK_NUMPAD_RIGHT:
+        if(!m_virtualModel->HasChildren(item)) {
+            return true;
+        }
+        if(!IsExpanded(item)) {
+            Expand(item);
+        } else if(m_virtualModel->GetChildrenCount(item)) {
+            wxTreeItemId child = m_virtualModel->GetChild(item, 0);
+            DoVirtualSelect(child, false, false);
+            EnsureVisible(child);
+        }
+        return true;
+    case WXK_RETURN:
+    case WXK_NUMPAD_ENTER:
+        SendVirtualEvent(wxEVT_TREE_ITEM_ACTIVATED, item);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void clTreeCtrl::DoVirtualMouseLeftDown(wxMouseEvent& event)
+{
+    int flags = 0;
+    int column = wxNOT_FOUND;
+    wxTreeItemId where = HitTest(event.GetPosition(), flags, column);
+    if(!where.IsOk()) {
+        return;
+    }
+
+    if(flags & wxTREE_HITTEST_ONITEMBUTTON) {
+        DoVirtualSetExpanded(where, !m_virtualRows.IsExpanded(where));
+    } else {
+        if(flags & wxTREE_HITTEST_ONITEMSTATEICON) {
+            // The model owns the value, let it toggle it
+            SendVirtualEvent(wxEVT_TREE_ITEM_VALUE_CHANGED, where, column);
+        }
+        DoVirtualSelect(where, event.ControlDown(), event.ShiftDown());
+        int row = m_virtualRows.GetRow(where);
+        if(row != wxNOT_FOUND) {
+            DoVirtualEnsureRowVisible(row);
+        }
+        if((flags & wxTREE_HITTEST_ONDROPDOWNARROW) && (m_virtualSelection.GetRowsCount() == 1)) {
+            SendVirtualEvent(wxEVT_TREE_CHOICE, where, column);
+        }
+    }
+    UpdateScrollBar();
+    Refresh();
+}
+
+bool clTreeCtrl::SendVirtualEvent(const wxEventType& type, const wxTreeItemId& item, int column)
+{
+    wxTreeEvent evt(type);
+    evt.SetEventObject(this);
+    evt.SetItem(item);
+    evt.SetInt(column);
+    GetEventHandler()->ProcessEvent(evt);
+    return evt.IsAllowed();
+}
+
+void clTreeCtrl::EnableBatchEvents(bool enable)
+{
+    m_batchEvents = enable;
+    if(!m_batchEvents) {
+        // Drop what was collected so far
+        m_batchSelectionChanged = false;
+    }
+}
+
+void clTreeCtrl::NotifySelectionChanged()
+{
+    if(!m_batchEvents) {
+        return;
+    }
+    m_batchSelectionChanged = true;
+    DoScheduleBatchEvents();
+}
+
+void clTreeCtrl::NotifyItemsDeleted(wxArrayTreeItemIds& items)
+{
+    if(!m_batchEvents || items.empty()) {
+        return;
+    }
+    // Sent right away: once the rows are freed, their ids may be given to new rows
+    clTreeItemsEvent evt(wxEVT_TREE_ITEMS_DELETED);
+    evt.SetEventObject(this);
+    evt.GetItems().swap(items);
+    GetEventHandler()->ProcessEvent(evt);
+}
+
+void clTreeCtrl::DoScheduleBatchEvents()
+{
+    // All the changes made until the next event loop iteration go into the same events
+    if(m_batchPending) {
+        return;
+    }
+    m_batchPending = true;
+    CallAfter(&clTreeCtrl::DoSendBatchEvents);
+}
+
+void clTreeCtrl::DoSendBatchEvents()
+{
+    // The handlers may change the tree again: this schedules a new batch
+    m_batchPending = false;
+    if(m_batchSelectionChanged) {
+        m_batchSelectionChanged = false;
+        clTreeItemsEvent evt(wxEVT_TREE_ITEMS_SELECTION_CHANGED);
+        evt.SetEventObject(this);
+        DoGetBatchSelections(evt.GetItems());
+        GetEventHandler()->ProcessEvent(evt);
+    }
+}
+
+void clTreeCtrl::DoGetBatchSelections(wxArrayTreeItemIds& items) const { GetSelections(items); }
+
+clTreeItemsEvent::clTreeItemsEvent(wxEventType commandType, int winid)
+    : wxCommandEvent(commandType, winid)
+{
+}
+
+clTreeItemsEvent::clTreeItemsEvent(const clTreeItemsEvent& event)
+    : wxCommandEvent(event)
+{
+    *this = event;
+}
+
+clTreeItemsEvent::~clTreeItemsEvent() {}
+
+clTreeItemsEvent& clTreeItemsEvent::operator=(const clTreeItemsEvent& src)
+{
+    // wxCommandEvent operator =
+    m_eventType = src.m_eventType;
+    m_id = src.m_id;
+    m_cmdString = src.m_cmdString;
+    m_commandInt = src.m_commandInt;
+    m_extraLong = src.m_extraLong;
+    m_clientData = src.m_clientData;
+    m_clientObject = src.m_clientObject;
+
+    // this class members
+    m_items = src.m_items;
+    return *this;
+}
+
+wxEvent* clTreeItemsEvent::Clone() const { return new clTreeItemsEvent(*this); }
@@ -5,6 +5,7 @@
 #include "clHeaderBar.h"
 #include "clScrolledPanel.h"
 #include "clTreeCtrlModel.h"
+#include "clTreeCtrlVirtualModel.h"
 #include "codelite_exports.h"
 #include <wx/arrstr.h>
 #include <wx/datetime.h>
@@ -20,6 +21,29 @@
 static const int wxTREE_HITTEST_ONDROPDOWNARROW = 0x2000;
 
 class clScrollBar;
+
+/**
+ * @brief a notification about many items at once (see clTreeCtrl::EnableBatchEvents)
+ */
+class WXDLLIMPEXP_SDK clTreeItemsEvent : public wxCommandEvent
+{
+protected:
+    wxArrayTreeItemIds m_items;
+
+public:
+    clTreeItemsEvent(wxEventType commandType = wxEVT_NULL, int winid = 0);
+    clTreeItemsEvent(const clTreeItemsEvent& event);
+    clTreeItemsEvent& operator=(const clTreeItemsEvent& src);
+    virtual ~clTreeItemsEvent();
+    virtual wxEvent* Clone() const;
+    void SetItems(const wxArrayTreeItemIds& items) { this->m_items = items; }
+    const wxArrayTreeItemIds& GetItems() const { return m_items; }
+    wxArrayTreeItemIds& GetItems() { return m_items; }
+};
+
+typedef void (wxEvtHandler::*clTreeItemsEventFunction)(clTreeItemsEvent&);
+#define clTreeItemsEventHandler(func) wxEVENT_HANDLER_CAST(clTreeItemsEventFunction, func)
+
 enum class eRendererType {
     RENDERER_DEFAULT = 0,
     RENDERER_DIRECT2D,
@@ -33,10 +57,24 @@ protected:
     bool m_needToClearDefaultHeader = true;
     long m_treeStyle = 0;
     int m_scrollLines = 0;
+    wxPoint m_mousePosition = wxDefaultPosition; // the last mouse position, wxDefaultPosition when outside
     bool m_bulkInsert = false;
     clSortFunc_t m_oldSortFunc;
     eRendererType m_renderer = eRendererType::RENDERER_DEFAULT;
 
+    // Virtual mode
+    clTreeCtrlVirtualModel* m_virtualModel = nullptr;
+    clTreeCtrlVirtualRows m_virtualRows;
+    size_t m_virtualFirstRow = 0;
+    wxTreeItemId m_virtualFocusedItem;
+    wxTreeItemId m_virtualAnchorItem;
+    clRowRanges m_virtualSelection; // the selected rows
+
+    // Batch events
+    bool m_batchEvents = false;
+    bool m_batchPending = false;
+    bool m_batchSelectionChanged = false;
+
 private:
     wxPoint DoFixPoint(const wxPoint& pt);
     wxTreeItemId DoGetSiblingVisibleItem(const wxTreeItemId& item, bool next) const;
@@ -57,14 +95,62 @@ private:
      */
     void DoUpdateHeader(const wxTreeItemId& item);
 
+    /**
+     * @brief make 'row' the hovered row (nullptr for none), only the previous and the new hovered rows are repainted
+     */
+    void DoSetHoveredRow(clRowEntry* row);
+    /**
+     * @brief hover the row under the last mouse position, the rows under a still mouse change when the view scrolls
+     */
+    void DoUpdateHoveredRow();
+
     void DoInitialize();
     clRowEntry* DoFind(clRowEntry* from, const wxString& what, size_t col, size_t searchFlags, bool next);
 
 protected:
     void UpdateScrollBar() override;
+    /**
+     * @brief give subclasses a chance to draw the rows themselves. Return true if the rows were drawn
+     */
+    virtual bool DoPaintRows(wxDC& dc);
+    /**
+     * @brief return 'count' reusable rows for drawing items which are not stored in the tree (see the virtual modes)
+     */
+    void DoGetVirtualSlots(size_t count, clRowEntry::Vec_t& slots);
+    /**
+     * @brief draw 'items' as the visible rows. 'firstRow' is the index of the first visible row in 'items'
+     */
+    void DoRenderRows(wxDC& dc, const clRowEntry::Vec_t& items, int firstRow);
+    wxDC& DoPrepareRowsBufferDC(wxMemoryDC& memDC, wxGCDC& gcdc) override;
+    wxTreeItemId DoHitTest(const wxPoint& point, int& flags, int& column) const;
+    /**
+     * @brief return the selected rows on screen, see DoRefreshSelectionChanges()
+     */
+    clRowEntry::Vec_t DoGetOnScreenSelection() const;
+    /**
+     * @brief refresh the on screen rows which selection state changed since 'selectedBefore' was taken
+     */
+    void DoRefreshSelectionChanges(const clRowEntry::Vec_t& selectedBefore);
+
+    // Virtual mode
+    size_t DoGetVirtualMaxFirstRow(size_t count) const;
+    void DoVirtualEnsureRowVisible(size_t row);
+    void DoVirtualSelect(const wxTreeItemId& item, bool ctrlDown, bool shiftDown);
+    bool DoVirtualSetExpanded(const wxTreeItemId& item, bool expand);
+    bool DoVirtualKeyDown(const wxKeyEvent& event);
+    void DoVirtualMouseLeftDown(wxMouseEvent& event);
+    bool SendVirtualEvent(const wxEventType& type, const wxTreeItemId& item, int column = 0);
     void DoAddHeader(const wxString& label, const wxBitmap& bmp, int width = wxCOL_WIDTH_AUTOSIZE);
     void UpdateLineHeight();
 
+    // Batch events
+    void DoScheduleBatchEvents();
+    void DoSendBatchEvents();
+    /**
+     * @brief return the selected items for the wxEVT_TREE_ITEMS_SELECTION_CHANGED event
+     */
+    virtual void DoGetBatchSelections(wxArrayTreeItemIds& items) const;
+
 public:
     void ScrollToBottom();
     int GetFirstItemPosition() const override;
@@ -83,6 +169,38 @@ public:
     }
 
     void SetDefaultFont(const wxFont& font) override;
+
+    /**
+     * @brief switch the tree into virtual mode. In virtual mode the items are not stored by the tree, the rows that are
+     * drawn or navigated are requested from 'model' on demand and only the expanded state is kept. The model is not
+     * owned by the tree. Pass nullptr to switch back into the normal mode. Any existing items are deleted.
+     * The item ids used by the tree are the model ids and the (hidden) root is the invalid id. In virtual mode, only
+     * the selection, expand/collapse, navigation, EnsureVisible and GetItemText/GetItemParent/ItemHasChildren methods
+     * can be used with the items. The selection is kept as ranges of visible rows: collapsing an item unselects its
+     * children
+     */
+    void SetVirtualModel(clTreeCtrlVirtualModel* model);
+    clTreeCtrlVirtualModel* GetVirtualModel() const { return m_virtualModel; }
+    bool IsVirtual() const { return m_virtualModel != nullptr; }
+
+    /**
+     * @brief call this after the items of the virtual model have changed
+     */
+    void RefreshVirtualItems();
+
+    /**
+     * @brief when enabled, the control also fires the wxEVT_TREE_ITEMS_SELECTION_CHANGED and wxEVT_TREE_ITEMS_DELETED
+     * events. The selection changes made during one event loop iteration are reported once. The items removed by one
+     * delete call are reported at once, before they are freed. The item by item events are still fired. Disabled by
+     * default. For clDataViewListCtrl, the items are converted with wxDataViewItem(item.GetID())
+     */
+    void EnableBatchEvents(bool enable);
+    bool IsBatchEventsEnabled() const { return m_batchEvents; }
+    /**
+     * @brief called by the model when the selection has changed or when items are about to be freed
+     */
+    void NotifySelectionChanged();
+    void NotifyItemsDeleted(wxArrayTreeItemIds& items);
     /**
      * @brief notify the control that we are doing bulk insert so avoid
      * not needed UI updates
@@ -198,6 +316,13 @@ public:
      */
     wxTreeItemId AppendItem(const wxTreeItemId& parent, const wxString& text, int image = -1, int selImage = -1,
                             wxTreeItemData* data = NULL);
+
+    /**
+     * @brief append many items to 'parent' at once. The items are linked in a single pass, the columns are measured
+     * once and the UI is updated once. The new items ids are returned in 'ids' (if not null)
+     */
+    void AppendItems(const wxTreeItemId& parent, const std::vector<clTreeItemInfo>& items,
+                     wxArrayTreeItemIds* ids = nullptr);
     /**
      * @brief Adds the root node to the tree, returning the new item.
      */
@@ -254,11 +379,27 @@ public:
      */
     void UnselectAll();
 
+    /**
+     * @brief select all the visible items (multiple selection trees only). The rows are selected as a single range, so
+     * this does not depend on the number of items
+     */
+    void SelectAll();
+
     /**
      * @brief Scrolls and/or expands items to ensure that the given item is visible.
      */
     void EnsureVisible(const wxTreeItemId& item);
 
+    /**
+     * @brief repaint the row of 'item' only. Does nothing if the item is not on screen
+     */
+    void RefreshItem(const wxTreeItemId& item);
+
+    /**
+     * @brief repaint the on screen rows from 'from' to 'to' (inclusive) only
+     */
+    void RefreshRange(const wxTreeItemId& from, const wxTreeItemId& to);
+
     /**
      * @brief is item expanded?
      */
@@ -311,9 +452,13 @@ public:
     wxTreeItemId GetPrevItem(const wxTreeItemId& item) const;
 
     /**
-     * @brief for compatibility, we dont really need to call this method manually
+     * @brief sort the children of 'item', recursively, using the sort function (see SetSortFunction). Items added
+     * while a sort function is set are already sorted, call this after changing the sort function. The default sort
+     * function uses all the cores. Set 'threadSafeSortFunction' to do the same with a custom sort function: it is
+     * then called from several threads at once, so it must not call the control nor modify the items (e.g. format
+     * their labels)
      */
-    void SortChildren(const wxTreeItemId& item) { wxUnusedVar(item); }
+    void SortChildren(const wxTreeItemId& item, bool threadSafeSortFunction = false);
 
     /**
      * @brief set item's image index
@@ -360,7 +505,9 @@ public:
     wxFont GetItemFont(const wxTreeItemId& item, size_t col = 0) const;
 
     /**
-     * @brief expand this item and all its children
+     * @brief expand this item and all its children. Fires wxEVT_TREE_EXPANDING_ALL and wxEVT_TREE_EXPANDED_ALL
+     * instead of an event pair per item: items populated on wxEVT_TREE_ITEM_EXPANDING must be populated on
+     * wxEVT_TREE_EXPANDING_ALL as well (see clTreeCtrlModel::ExpandAllChildren)
      */
     void ExpandAllChildren(const wxTreeItemId& item);
 
@@ -370,7 +517,8 @@ public:
     void ExpandAll() { ExpandAllChildren(GetRootItem()); }
 
     /**
-     * @brief expand this item and all its children
+     * @brief collapse this item and all its children. Fires wxEVT_TREE_COLLAPSING_ALL and wxEVT_TREE_COLLAPSED_ALL
+     * instead of an event pair per item
      */
     void CollapseAllChildren(const wxTreeItemId& item);
 
@@ -440,7 +588,7 @@ protected:
     void OnRightDown(wxMouseEvent& event);
     void OnMouseLeftDClick(wxMouseEvent& event);
     void DoMouseScroll(const wxMouseEvent& event) override;
-    void ProcessIdle() override;
+    void OnMouseMotion(wxMouseEvent& event);
     void OnLeaveWindow(wxMouseEvent& event);
     void OnEnterWindow(wxMouseEvent& event);
     void OnContextMenu(wxContextMenuEvent& event);
@@ -451,4 +599,15 @@ protected:
 
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_TREE_ITEM_VALUE_CHANGED, wxTreeEvent);
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_TREE_CHOICE, wxTreeEvent);
+// The selection has changed, the event carries all the selected items
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_TREE_ITEMS_SELECTION_CHANGED, clTreeItemsEvent);
+// Items were removed from the tree, the event carries their ids. It is sent before the items are freed, so their data
+// can still be read (e.g. GetItemData), but the tree should not be changed by the handler. Deleting an item with
+// children reports the children first, then the item. Like wxEVT_TREE_DELETE_ITEM, this is not fired by DeleteAllItems
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_TREE_ITEMS_DELETED, clTreeItemsEvent);
+// ExpandAllChildren/CollapseAllChildren, the event item is the subtree root. The "ING" events can be vetoed
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_TREE_EXPANDING_ALL, wxTreeEvent);
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_TREE_EXPANDED_ALL, wxTreeEvent);
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_TREE_COLLAPSING_ALL, wxTreeEvent);
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_TREE_COLLAPSED_ALL, wxTreeEvent);
 #endif // CLTREECTRL_H
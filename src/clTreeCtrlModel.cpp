@@ -1,6 +1,9 @@
 #include "clTreeCtrl.h"
 #include "clTreeCtrlModel.h"
+#include "clParallelSort.h"
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <wx/dc.h>
 #include <wx/settings.h>
 #include <wx/treebase.h>
@@ -16,15 +19,13 @@ clTreeCtrlModel::clTreeCtrlModel(clTreeCtrl* tree)
     : m_tree(tree)
 {
     // Setup a default compare function
-    m_shouldInsertBeforeFunc = [&](clRowEntry* a, clRowEntry* b) {
-        return a->GetLabel(0).CmpNoCase(b->GetLabel(0)) < 0;
-    };
+    m_shouldInsertBeforeFunc = &clTreeCtrlModel::DefaultSortFunction;
 }
 
 clTreeCtrlModel::~clTreeCtrlModel()
 {
     m_shutdown = true; // Disable events
-    wxDELETE(m_root);
+    m_pool.Release([&]() { wxDELETE(m_root); });
 }
 
 void clTreeCtrlModel::GetNextItems(clRowEntry* from, int count, clRowEntry::Vec_t& items, bool selfIncluded) const
@@ -46,7 +47,7 @@ wxTreeItemId clTreeCtrlModel::AddRoot(const wxString& text, int image, int selIm
     if(m_root) {
         return wxTreeItemId(m_root);
     }
-    m_root = new clRowEntry(m_tree, text, image, selImage);
+    m_root = new(GetMemoryPool()) clRowEntry(m_tree, text, image, selImage);
     m_root->SetClientData(data);
     if(m_tree->GetTreeStyle() & wxTR_HIDE_ROOT) {
         m_root->SetHidden(true);
@@ -65,10 +66,159 @@ wxTreeItemId clTreeCtrlModel::GetRootItem() const
 
 void clTreeCtrlModel::UnselectAll()
 {
-    for(size_t i = 0; i < m_selectedItems.size(); ++i) {
-        m_selectedItems[i]->SetSelected(false);
+    if(GetSelectionsCount() == 0) {
+        return;
+    }
+    for(clRowEntry* item : m_selectedItems) {
+        item->SetSelected(false);
+    }
+    DoClearSelectedItems();
+    m_selectedRanges.Clear();
+    DoSelectionChanged();
+}
+
+void clTreeCtrlModel::SelectAll()
+{
+    if(!m_root || !IsMultiSelection() || GetExpandedLines() == 0) {
+        return;
+    }
+    bool wasEmpty = (GetSelectionsCount() == 0);
+    UnselectAll();
+    m_selectedRanges.Add(0, GetExpandedLines() - 1);
+    DoSelectionChanged();
+    if(wasEmpty) {
+        wxTreeEvent evt(wxEVT_TREE_SEL_CHANGED);
+        evt.SetEventObject(m_tree);
+        evt.SetItem(wxTreeItemId(GetItemFromIndex(0)));
+        SendEvent(evt);
+    }
+}
+
+void clTreeCtrlModel::SelectRange(clRowEntry* from, clRowEntry* to)
+{
+    if(!from || !to || !IsMultiSelection()) {
+        return;
+    }
+    if(!from->IsVisible() || !to->IsVisible()) {
+        // The ranges only hold visible rows, select the items one by one
+        clRowEntry::Vec_t range;
+        GetRange(from, to, range);
+        std::for_each(range.begin(), range.end(), [&](clRowEntry* p) { AddSelection(wxTreeItemId(p)); });
+        return;
+    }
+    int fromRow = GetItemIndex(from);
+    int toRow = GetItemIndex(to);
+    if(fromRow == wxNOT_FOUND || toRow == wxNOT_FOUND) {
+        return;
+    }
+    size_t first = std::min(fromRow, toRow);
+    size_t last = std::max(fromRow, toRow);
+    bool wasEmpty = (GetSelectionsCount() == 0);
+
+    // The items already selected inside the range now belong to the range
+    std::list<clRowEntry*>::iterator iter = m_selectedItems.begin();
+    while(iter != m_selectedItems.end()) {
+        clRowEntry* item = *(iter++);
+        int row = item->IsVisible() ? GetItemIndex(item) : wxNOT_FOUND;
+        if(row != wxNOT_FOUND && (size_t)row >= first && (size_t)row <= last) {
+            DoRemoveSelectedItem(item);
+        }
     }
+    m_selectedRanges.Add(first, last);
+    DoSelectionChanged();
+
+    if(wasEmpty) {
+        wxTreeEvent evt(wxEVT_TREE_SEL_CHANGED);
+        evt.SetEventObject(m_tree);
+        evt.SetItem(wxTreeItemId(fromRow < toRow ? from : to));
+        SendEvent(evt);
+    }
+}
+
+bool clTreeCtrlModel::DoIsInSelectedRanges(const clRowEntry* item) const
+{
+    if(!item || !item->IsVisible()) {
+        return false;
+    }
+    int row = GetItemIndex(const_cast<clRowEntry*>(item));
+    if(row == wxNOT_FOUND) {
+        return false;
+    }
+    return m_selectedRanges.Contains(row);
+}
+
+void clTreeCtrlModel::DoFlushSelectedRanges()
+{
+    clRowRanges ranges;
+    ranges.Swap(m_selectedRanges);
+    m_selectedItemsIndex.reserve(m_selectedItemsIndex.size() + ranges.GetRowsCount());
+    for(const clRowRanges::const_iterator::value_type& range : ranges) {
+        clRowEntry* item = GetItemFromIndex(range.first);
+        for(size_t row = range.first; item && row <= range.second; ++row) {
+            DoAddSelectedItem(item);
+            item = item->GetNextVisible();
+        }
+    }
+}
+
+void clTreeCtrlModel::DoAddSelectedItem(clRowEntry* item)
+{
+    if(item->HasSelectionFlag()) {
+        return;
+    }
+    item->SetSelected(true);
+    m_selectedItemsIndex.insert({ item, m_selectedItems.insert(m_selectedItems.end(), item) });
+}
+
+bool clTreeCtrlModel::DoRemoveSelectedItem(clRowEntry* item)
+{
+    if(!item->HasSelectionFlag()) {
+        return false;
+    }
+    item->SetSelected(false);
+    auto iter = m_selectedItemsIndex.find(item);
+    if(iter == m_selectedItemsIndex.end()) {
+        return false;
+    }
+    m_selectedItems.erase(iter->second);
+    m_selectedItemsIndex.erase(iter);
+    return true;
+}
+
+void clTreeCtrlModel::DoClearSelectedItems()
+{
     m_selectedItems.clear();
+    m_selectedItemsIndex.clear();
+}
+
+void clTreeCtrlModel::DoUnselectItem(clRowEntry* item)
+{
+    if(DoRemoveSelectedItem(item)) {
+        DoSelectionChanged();
+    } else if(IsInSelectedRanges(item)) {
+        m_selectedRanges.Remove(GetItemIndex(item));
+        DoSelectionChanged();
+    }
+}
+
+void clTreeCtrlModel::DoSelectionChanged()
+{
+    if(m_tree && !m_shutdown) {
+        m_tree->NotifySelectionChanged();
+    }
+}
+
+void clTreeCtrlModel::GetSelections(clRowEntry::Vec_t& items) const
+{
+    items.reserve(items.size() + GetSelectionsCount());
+    items.insert(items.end(), m_selectedItems.begin(), m_selectedItems.end());
+    for(const clRowRanges::const_iterator::value_type& range : m_selectedRanges) {
+        clRowEntry* item = GetItemFromIndex(range.first);
+        for(size_t row = range.first; item && row <= range.second; ++row) {
+            items.push_back(item);
+            item = item->GetNextVisible();
+        }
+    }
 }
 
 void clTreeCtrlModel::SelectItem(const wxTreeItemId& item, bool select_it, bool addSelection, bool clear_old_selection)
@@ -85,32 +235,29 @@ void clTreeCtrlModel::SelectItem(const wxTreeItemId& item, bool select_it, bool
         return;
     }
 
-    if(select_it) {
-        clRowEntry::Vec_t::iterator iter =
-            std::find_if(m_selectedItems.begin(), m_selectedItems.end(), [&](clRowEntry* p) { return (p == child); });
-        // If the item is already selected, don't select it again
-        if(iter != m_selectedItems.end()) {
-            return;
-        }
+    // If the item is already selected, don't select it again
+    if(select_it && child->IsSelected()) {
+        return;
     }
 
     // Fire an event only if the was no selection prior to this item
-    bool fire_event = (m_selectedItems.empty() && select_it);
+    bool fire_event = (GetSelectionsCount() == 0 && select_it);
 
     if(IsMultiSelection() && addSelection) {
-        // If we are unselecting it, remove it from the array
-        clRowEntry::Vec_t::iterator iter =
-            std::find_if(m_selectedItems.begin(), m_selectedItems.end(), [&](clRowEntry* p) { return (p == child); });
-        if(iter != m_selectedItems.end() && !select_it) {
-            m_selectedItems.erase(iter);
+        // If we are unselecting it, remove it from the selection
+        if(!select_it) {
+            DoUnselectItem(child);
         }
     } else {
         if(!ClearSelections(item != GetSingleSelection())) {
             return;
         }
     }
-    child->SetSelected(select_it);
-    m_selectedItems.push_back(child);
+    if(!select_it) {
+        return;
+    }
+    DoAddSelectedItem(child);
+    DoSelectionChanged();
     if(fire_event) {
         wxTreeEvent evt(wxEVT_TREE_SEL_CHANGED);
         evt.SetEventObject(m_tree);
@@ -121,22 +268,38 @@ void clTreeCtrlModel::SelectItem(const wxTreeItemId& item, bool select_it, bool
 
 void clTreeCtrlModel::Clear()
 {
-    m_selectedItems.clear();
+    if(GetSelectionsCount() != 0) {
+        DoSelectionChanged();
+    }
+    DoClearSelectedItems();
+    m_selectedRanges.Clear();
     for(size_t i = 0; i < m_onScreenItems.size(); ++i) {
-        m_onScreenItems[i]->ClearRects();
+        m_onScreenItems[i]->SetOnScreenIndex(wxNOT_FOUND);
     }
     m_onScreenItems.clear();
+    m_hoveredItem = nullptr;
 }
 
 void clTreeCtrlModel::SetOnScreenItems(const clRowEntry::Vec_t& items)
 {
-    // Clear the old visible items. But only, if the item does not appear in both lists
+    // Number the new items. The old items that were not numbered again are no longer on screen
+    for(size_t i = 0; i < m_onScreenItems.size(); ++i) {
+        m_onScreenItems[i]->SetOnScreenIndex(wxNOT_FOUND);
+    }
+    for(size_t i = 0; i < items.size(); ++i) {
+        items[i]->SetOnScreenIndex(i);
+    }
     for(size_t i = 0; i < m_onScreenItems.size(); ++i) {
         clRowEntry* visibleItem = m_onScreenItems[i];
-        clRowEntry::Vec_t::const_iterator iter =
-            std::find_if(items.begin(), items.end(), [&](clRowEntry* item) { return item == visibleItem; });
-        if(iter == items.end()) {
-            m_onScreenItems[i]->ClearRects();
+        if(visibleItem->GetOnScreenIndex() == wxNOT_FOUND) {
+            if(!m_formatCache) {
+                m_onScreenItems[i]->ClearFormatCache();
+            }
+            if(visibleItem == m_hoveredItem) {
+                // The mouse can't be over it
+                m_hoveredItem->SetHovered(false);
+                m_hoveredItem = nullptr;
+            }
         }
     }
     m_onScreenItems = items;
@@ -168,30 +331,220 @@ wxTreeItemId clTreeCtrlModel::AppendItem(const wxTreeItemId& parent, const wxStr
     }
     parentNode = ToPtr(parent);
 
-    clRowEntry* child = new clRowEntry(m_tree, text, image, selImage);
+    clRowEntry* child = new(GetMemoryPool()) clRowEntry(m_tree, text, image, selImage);
     child->SetClientData(data);
     // Find the best insertion point
-    clRowEntry* prevItem = nullptr;
     if(!parentNode->IsRoot() && (m_tree->GetTreeStyle() & wxTR_SORT_TOP_LEVEL)) {
         // We have been requested to sort top level items only
         parentNode->AddChild(child);
     } else if(m_shouldInsertBeforeFunc != nullptr) {
-        const clRowEntry::Vec_t& children = parentNode->GetChildren();
-        // Loop over the parent's children and add execute the compare function
-        for(int i = ((int)children.size() - 1); i >= 0; --i) {
-            if(!m_shouldInsertBeforeFunc(child, children[i])) {
-                // Our item should be placed _after_ children[i]s
-                prevItem = ToPtr(children[i]);
-                break;
-            }
-        }
-        parentNode->InsertChild(child, prevItem);
+        parentNode->InsertChildAt(child, DoGetInsertPosition(parentNode, child));
     } else {
         parentNode->AddChild(child);
     }
     return wxTreeItemId(child);
 }
 
+bool clTreeCtrlModel::DefaultSortFunction(clRowEntry* a, clRowEntry* b)
+{
+    return a->GetLabel(0).CmpNoCase(b->GetLabel(0)) < 0;
+}
+
+bool clTreeCtrlModel::IsDefaultSortFunction() const
+{
+    typedef bool (*SortFunctionPtr_t)(clRowEntry*, clRowEntry*);
+    const SortFunctionPtr_t* func = m_shouldInsertBeforeFunc.target<SortFunctionPtr_t>();
+    return func && (*func == &clTreeCtrlModel::DefaultSortFunction);
+}
+
+int clTreeCtrlModel::CompareSortKey(const wxString& key, const wxString& label)
+{
+    wxString::const_iterator k = key.begin();
+    wxString::const_iterator l = label.begin();
+    for(; (k != key.end()) && (l != label.end()); ++k, ++l) {
+        wxChar kc = *k;
+        wxChar lc = wxTolower(*l);
+        if(kc != lc) {
+            return (kc < lc) ? -1 : 1;
+        }
+    }
+    if(k == key.end()) {
+        return (l == label.end()) ? 0 : -1;
+    }
+    return 1;
+}
+
+size_t clTreeCtrlModel::DoGetInsertPosition(clRowEntry* parent, clRowEntry* child) const
+{
+    // The children are sorted: place the item after the last child that should not come after it
+    const clRowEntry::Vec_t& children = parent->GetChildren();
+    clRowEntry::Vec_t::const_iterator where;
+    if(IsDefaultSortFunction()) {
+        // Lower the new item's label once
+        wxString key = GetSortKey(child->GetLabel(0));
+        where = std::upper_bound(children.begin(), children.end(), key, [](const wxString& k, clRowEntry* c) {
+            return CompareSortKey(k, c->GetLabel(0)) < 0;
+        });
+    } else {
+        where = std::upper_bound(children.begin(), children.end(), child, m_shouldInsertBeforeFunc);
+    }
+    return where - children.begin();
+}
+
+void clTreeCtrlModel::AppendItems(const wxTreeItemId& parent, const std::vector<clTreeItemInfo>& items,
+                                  clRowEntry::Vec_t& rows)
+{
+    rows.clear();
+    if(!ToPtr(parent)) {
+        return;
+    }
+
+    rows.reserve(items.size());
+    for(const clTreeItemInfo& info : items) {
+        clRowEntry* child = new(GetMemoryPool()) clRowEntry(m_tree, info.text, info.image, info.selImage);
+        child->SetClientData(info.data);
+        rows.push_back(child);
+    }
+    AddRows(parent, rows);
+}
+
+void clTreeCtrlModel::AddRows(const wxTreeItemId& parent, const clRowEntry::Vec_t& rows)
+{
+    clRowEntry* parentNode = ToPtr(parent);
+    if(!parentNode || rows.empty()) {
+        return;
+    }
+
+    // Same placement rules as AppendItem
+    bool sortTopLevelOnly = !parentNode->IsRoot() && (m_tree->GetTreeStyle() & wxTR_SORT_TOP_LEVEL);
+    if(sortTopLevelOnly || !m_shouldInsertBeforeFunc) {
+        parentNode->AddChildren(rows);
+        return;
+    }
+
+    clRowEntry::Vec_t sorted = rows;
+    DoSortRows(sorted, false);
+    parentNode->AddChildren(sorted, m_shouldInsertBeforeFunc);
+}
+
+void clTreeCtrlModel::DoSortRows(clRowEntry::Vec_t& rows, bool parallel) const
+{
+    if(rows.size() < 2) {
+        return;
+    }
+    if(!IsDefaultSortFunction()) {
+        if(parallel) {
+            clParallelStableSort(rows.begin(), rows.end(), m_shouldInsertBeforeFunc);
+        } else {
+            std::stable_sort(rows.begin(), rows.end(), m_shouldInsertBeforeFunc);
+        }
+        return;
+    }
+
+    // Compute the keys once, and not once per comparison
+    typedef std::pair<wxString, clRowEntry*> SortKey_t;
+    std::vector<SortKey_t> keys;
+    keys.reserve(rows.size());
+    for(clRowEntry* row : rows) {
+        keys.push_back({ GetSortKey(row->GetLabel(0)), row });
+    }
+    auto lessThan = [](const SortKey_t& a, const SortKey_t& b) { return a.first < b.first; };
+    if(parallel) {
+        clParallelStableSort(keys.begin(), keys.end(), lessThan);
+    } else {
+        std::stable_sort(keys.begin(), keys.end(), lessThan);
+    }
+    for(size_t i = 0; i < keys.size(); ++i) {
+        rows[i] = keys[i].second;
+    }
+}
+
+void clTreeCtrlModel::SortChildren(const wxTreeItemId& item, bool threadSafeSortFunction)
+{
+    clRowEntry* parent = ToPtr(item);
+    if(!parent || !m_shouldInsertBeforeFunc) {
+        return;
+    }
+
+    // Collect the sibling groups to sort. Large groups are sorted one by one using all the cores, the others are
+    // shared between the worker threads. A custom sort function may not be thread safe: it is called from this thread
+    // only, unless the caller says otherwise
+    bool parallel = IsDefaultSortFunction() || threadSafeSortFunction;
+    static const size_t LARGE_GROUP_SIZE = 32768;
+    std::vector<clRowEntry::Vec_t*> groups;
+    std::vector<clRowEntry::Vec_t*> largeGroups;
+    bool sortTopLevelOnly = m_tree->GetTreeStyle() & wxTR_SORT_TOP_LEVEL;
+    clRowEntry::Vec_t stack = { parent };
+    while(!stack.empty()) {
+        clRowEntry* node = stack.back();
+        stack.pop_back();
+        clRowEntry::Vec_t& children = node->GetChildrenForUpdate();
+        if(children.size() > 1 && (!sortTopLevelOnly || node->IsRoot())) {
+            if(children.size() >= LARGE_GROUP_SIZE) {
+                largeGroups.push_back(&children);
+            } else {
+                groups.push_back(&children);
+            }
+        }
+        if(!sortTopLevelOnly) {
+            stack.insert(stack.end(), children.begin(), children.end());
+        }
+    }
+    if(groups.empty() && largeGroups.empty()) {
+        return;
+    }
+
+    // The item that follows the subtree in the flattened list
+    clRowEntry* last = parent;
+    while(last->GetLastChild()) {
+        last = last->GetLastChild();
+    }
+    clRowEntry* after = last->GetNext();
+
+    for(clRowEntry::Vec_t* group : largeGroups) {
+        DoSortRows(*group, parallel);
+    }
+
+    size_t threadsCount = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), groups.size());
+    if(!parallel || (threadsCount < 2)) {
+        for(clRowEntry::Vec_t* group : groups) {
+            DoSortRows(*group, false);
+        }
+    } else {
+        std::atomic<size_t> nextGroup(0);
+        auto worker = [&]() {
+            for(size_t i = nextGroup++; i < groups.size(); i = nextGroup++) {
+                DoSortRows(*groups[i], false);
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(threadsCount);
+        for(size_t i = 0; i < threadsCount; ++i) {
+            threads.emplace_back(worker);
+        }
+        for(std::thread& t : threads) {
+            t.join();
+        }
+    }
+
+    // Rebuild the flattened list of the subtree (pre-order)
+    clRowEntry* prev = parent;
+    stack.assign(parent->GetChildren().rbegin(), parent->GetChildren().rend());
+    while(!stack.empty()) {
+        clRowEntry* node = stack.back();
+        stack.pop_back();
+        prev->SetNext(node);
+        node->SetPrev(prev);
+        prev = node;
+        const clRowEntry::Vec_t& children = node->GetChildren();
+        stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+    prev->SetNext(after);
+    if(after) {
+        after->SetPrev(prev);
+    }
+}
+
 wxTreeItemId clTreeCtrlModel::InsertItem(const wxTreeItemId& parent, const wxTreeItemId& previous, const wxString& text,
                                          int image, int selImage, wxTreeItemData* data)
 {
@@ -208,32 +561,38 @@ wxTreeItemId clTreeCtrlModel::InsertItem(const wxTreeItemId& parent, const wxTre
         return wxTreeItemId();
     }
 
-    clRowEntry* child = new clRowEntry(m_tree, text, image, selImage);
+    clRowEntry* child = new(GetMemoryPool()) clRowEntry(m_tree, text, image, selImage);
     child->SetClientData(data);
     parentNode->InsertChild(child, pPrev);
     return wxTreeItemId(child);
 }
 
-void clTreeCtrlModel::ExpandAllChildren(const wxTreeItemId& item) { DoExpandAllChildren(item, true); }
+bool clTreeCtrlModel::ExpandAllChildren(const wxTreeItemId& item) { return DoExpandAllChildren(item, true); }
 
-void clTreeCtrlModel::CollapseAllChildren(const wxTreeItemId& item) { DoExpandAllChildren(item, false); }
+bool clTreeCtrlModel::CollapseAllChildren(const wxTreeItemId& item) { return DoExpandAllChildren(item, false); }
 
-void clTreeCtrlModel::DoExpandAllChildren(const wxTreeItemId& item, bool expand)
+bool clTreeCtrlModel::DoExpandAllChildren(const wxTreeItemId& item, bool expand)
 {
     clRowEntry* p = ToPtr(item);
     if(!p) {
-        return;
+        return false;
     }
-    while(p) {
-        if(p->HasChildren()) {
-            if(expand && !p->IsExpanded()) {
-                p->SetExpanded(true);
-            } else if(!expand && p->IsExpanded()) {
-                p->SetExpanded(false);
-            }
-        }
-        p = p->GetNext();
+    wxTreeEvent before(expand ? wxEVT_TREE_EXPANDING_ALL : wxEVT_TREE_COLLAPSING_ALL);
+    before.SetItem(item);
+    before.SetEventObject(m_tree);
+    SendEvent(before);
+    if(!before.IsAllowed()) {
+        return false;
     }
+
+    // Only the subtree of 'item' is visited, the rows count is updated once
+    p->SetSubtreeExpanded(expand);
+
+    wxTreeEvent after(expand ? wxEVT_TREE_EXPANDED_ALL : wxEVT_TREE_COLLAPSED_ALL);
+    after.SetItem(item);
+    after.SetEventObject(m_tree);
+    SendEvent(after);
+    return true;
 }
 
 wxTreeItemId clTreeCtrlModel::GetItemBefore(const wxTreeItemId& item, bool visibleItem) const
@@ -252,12 +611,26 @@ void clTreeCtrlModel::DeleteItem(const wxTreeItemId& item)
     if(!node) {
         return;
     }
+    if(node == m_root) {
+        // No need to convert the selected rows ranges into items that are about to be deleted
+        m_selectedRanges.Clear();
+    }
+    if(node == m_root && m_usePool) {
+        // Deleting the whole tree: hand the memory back to the system in one go instead of block by block
+        m_pool.Release([&]() { DoDeleteItem(node); });
+    } else {
+        DoDeleteItem(node);
+    }
+}
+
+void clTreeCtrlModel::DoDeleteItem(clRowEntry* node)
+{
     node->DeleteAllChildren();
 
     // Send the delete event
     wxTreeEvent event(wxEVT_TREE_DELETE_ITEM);
     event.SetEventObject(m_tree);
-    event.SetItem(item);
+    event.SetItem(wxTreeItemId(node));
     SendEvent(event);
 
     // Delete the item itself
@@ -269,34 +642,50 @@ void clTreeCtrlModel::DeleteItem(const wxTreeItemId& item)
     }
 }
 
+void clTreeCtrlModel::EnableMemoryPool(bool enable)
+{
+    if(!IsEmpty() || (enable == m_usePool)) {
+        return;
+    }
+    m_usePool = enable;
+    if(!m_usePool) {
+        m_pool.Release();
+    }
+}
+
 void clTreeCtrlModel::NodeDeleted(clRowEntry* node)
 {
     // Clear the various caches
-    {
-        clRowEntry::Vec_t::iterator iter =
-            std::find_if(m_selectedItems.begin(), m_selectedItems.end(), [&](clRowEntry* n) { return n == node; });
-        if(iter != m_selectedItems.end()) {
-            m_selectedItems.erase(iter);
-            if(m_selectedItems.empty()) {
-                // Dont leave the tree without a selected item
-                if(node->GetNext()) {
-                    SelectItem(wxTreeItemId(node->GetNext()));
-                }
+    if(DoRemoveSelectedItem(node)) {
+        DoSelectionChanged();
+        if(GetSelectionsCount() == 0) {
+            // Dont leave the tree without a selected item
+            if(node->GetNext()) {
+                SelectItem(wxTreeItemId(node->GetNext()));
             }
         }
     }
 
-    {
-        clRowEntry::Vec_t::iterator iter =
-            std::find_if(m_onScreenItems.begin(), m_onScreenItems.end(), [&](clRowEntry* n) { return n == node; });
-        if(iter != m_onScreenItems.end()) {
-            m_onScreenItems.erase(iter);
+    if(IsOnScreen(node)) {
+        // The items below it move one row up
+        size_t index = node->GetOnScreenIndex();
+        m_onScreenItems.erase(m_onScreenItems.begin() + index);
+        for(size_t i = index; i < m_onScreenItems.size(); ++i) {
+            m_onScreenItems[i]->SetOnScreenIndex(i);
         }
     }
     {
         if(m_firstItemOnScreen == node) {
             m_firstItemOnScreen = nullptr;
         }
+        if(m_hoveredItem == node) {
+            m_hoveredItem = nullptr;
+        }
+    }
+    if(m_tree && !m_shutdown && m_tree->IsBatchEventsEnabled()) {
+        wxArrayTreeItemIds items;
+        items.push_back(wxTreeItemId(node));
+        m_tree->NotifyItemsDeleted(items);
     }
     {
         if(m_root == node) {
@@ -305,6 +694,40 @@ void clTreeCtrlModel::NodeDeleted(clRowEntry* node)
     }
 }
 
+bool clTreeCtrlModel::NodesDeleted(clRowEntry* first, clRowEntry* after)
+{
+    size_t selectionsCount = GetSelectionsCount();
+    if(!m_selectedItems.empty()) {
+        for(clRowEntry* node = first; node != after; node = node->GetNext()) {
+            DoRemoveSelectedItem(node);
+        }
+    }
+    if(GetSelectionsCount() != selectionsCount) {
+        DoSelectionChanged();
+    }
+    auto isDeleting = [](clRowEntry* n) { return n->IsDeleting(); };
+    m_onScreenItems.erase(std::remove_if(m_onScreenItems.begin(), m_onScreenItems.end(), isDeleting),
+                          m_onScreenItems.end());
+    for(size_t i = 0; i < m_onScreenItems.size(); ++i) {
+        m_onScreenItems[i]->SetOnScreenIndex(i);
+    }
+    if(m_firstItemOnScreen && m_firstItemOnScreen->IsDeleting()) {
+        m_firstItemOnScreen = nullptr;
+    }
+    if(m_hoveredItem && m_hoveredItem->IsDeleting()) {
+        m_hoveredItem = nullptr;
+    }
+    if(m_tree && !m_shutdown && m_tree->IsBatchEventsEnabled()) {
+        // The items are freed by the caller, once we return
+        wxArrayTreeItemIds items;
+        for(clRowEntry* node = first; node != after; node = node->GetNext()) {
+            items.push_back(wxTreeItemId(node));
+        }
+        m_tree->NotifyItemsDeleted(items);
+    }
+    return (selectionsCount != 0) && (GetSelectionsCount() == 0);
+}
+
 bool clTreeCtrlModel::NodeExpanding(clRowEntry* node, bool expanding)
 {
     wxTreeEvent before(expanding ? wxEVT_TREE_ITEM_EXPANDING : wxEVT_TREE_ITEM_COLLAPSING);
@@ -336,10 +759,13 @@ bool clTreeCtrlModel::SendEvent(wxEvent& event)
 
 wxTreeItemId clTreeCtrlModel::GetSingleSelection() const
 {
-    if(m_selectedItems.empty()) {
-        return wxTreeItemId();
+    if(!m_selectedItems.empty()) {
+        return wxTreeItemId(m_selectedItems.back());
+    }
+    if(!m_selectedRanges.IsEmpty()) {
+        return wxTreeItemId(GetItemFromIndex(m_selectedRanges.GetFirstRow()));
     }
-    return wxTreeItemId(m_selectedItems.back());
+    return wxTreeItemId();
 }
 
 int clTreeCtrlModel::GetItemIndex(clRowEntry* item) const
@@ -350,18 +776,24 @@ int clTreeCtrlModel::GetItemIndex(clRowEntry* item) const
     if(!m_root) {
         return wxNOT_FOUND;
     }
-    int counter = 0;
-    clRowEntry* current = m_root;
-    while(current) {
-        if(current == item) {
-            return counter;
+    // Climb up to the root and sum the visible rows that are placed before each node on the path
+    size_t index = 0;
+    clRowEntry* current = item;
+    clRowEntry* parent = item->GetParent();
+    while(parent) {
+        if(parent->IsExpanded()) {
+            index += current->GetRowsOffsetInParent();
+        } else {
+            // 'item' is inside a collapsed subtree, only the rows placed before the parent are counted
+            index = 0;
         }
-        if(current->IsVisible()) {
-            ++counter;
+        if(!parent->IsHidden()) {
+            ++index;
         }
-        current = current->GetNext();
+        current = parent;
+        parent = parent->GetParent();
     }
-    return wxNOT_FOUND;
+    return (current == m_root) ? (int)index : wxNOT_FOUND;
 }
 
 bool clTreeCtrlModel::GetRange(clRowEntry* from, clRowEntry* to, clRowEntry::Vec_t& items) const
@@ -388,6 +820,8 @@ bool clTreeCtrlModel::GetRange(clRowEntry* from, clRowEntry* to, clRowEntry::Vec
 
     clRowEntry* start_item = index1 > index2 ? to : from;
     clRowEntry* end_item = index1 > index2 ? from : to;
+    // When the end item is visible, we can skip collapsed subtrees
+    bool visibleOnly = end_item->IsVisible();
     clRowEntry* current = start_item;
     while(current) {
         if(current == end_item) {
@@ -397,7 +831,7 @@ bool clTreeCtrlModel::GetRange(clRowEntry* from, clRowEntry* to, clRowEntry::Vec
         if(current->IsVisible()) {
             items.push_back(current);
         }
-        current = current->GetNext();
+        current = visibleOnly ? current->GetNextVisible() : current->GetNext();
     }
     return true;
 }
@@ -407,7 +841,7 @@ size_t clTreeCtrlModel::GetExpandedLines() const
     if(!GetRoot()) {
         return 0;
     }
-    return m_root->GetExpandedLines();
+    return m_root->GetRowsCount();
 }
 
 clRowEntry* clTreeCtrlModel::GetItemFromIndex(int index) const
@@ -418,16 +852,20 @@ clRowEntry* clTreeCtrlModel::GetItemFromIndex(int index) const
     if(!m_root) {
         return nullptr;
     }
-    int curIndex = -1;
+    // Descend from the root, each step picks the child whose subtree contains the requested row
+    size_t offset = index;
     clRowEntry* current = m_root;
     while(current) {
-        if(current->IsVisible()) {
-            ++curIndex;
+        if(!current->IsHidden()) {
+            if(offset == 0) {
+                return current;
+            }
+            --offset;
         }
-        if(curIndex == index) {
-            return current;
+        if(!current->IsExpanded()) {
+            return nullptr;
         }
-        current = current->GetNext();
+        current = current->GetChildAtRowsOffset(offset);
     }
     return nullptr;
 }
@@ -442,61 +880,33 @@ void clTreeCtrlModel::SelectChildren(const wxTreeItemId& item)
     if(!ClearSelections(true)) {
         return;
     }
-    std::for_each(parent->GetChildren().begin(), parent->GetChildren().end(),
-                  [&](clRowEntry* child) { AddSelection(wxTreeItemId(child)); });
+    const clRowEntry::Vec_t& children = parent->GetChildren();
+    std::for_each(children.begin(), children.end(), [&](clRowEntry* child) { AddSelection(wxTreeItemId(child)); });
 }
 
 clRowEntry* clTreeCtrlModel::GetNextSibling(clRowEntry* item) const
 {
-    if(!item->GetParent()) {
-        return nullptr;
-    }
-    const clRowEntry::Vec_t& children = item->GetParent()->GetChildren();
-    if(children.empty()) {
-        return nullptr;
-    }
-    size_t where = -1;
-    for(size_t i = 0; i < children.size(); ++i) {
-        if(item == children[i]) {
-            where = i;
-            break;
-        }
-    }
-
-    // if we couldnt find 'item' in the children list or if it's the last child
-    // return nullptr
-    if((where == (size_t)-1) || (where == (children.size() - 1))) {
+    clRowEntry* parent = item->GetParent();
+    if(!parent) {
         return nullptr;
     }
-    ++where;
-    return children[where];
+    // The next sibling follows the item's subtree in the sequential list
+    clRowEntry* next = item->GetLastDescendant()->GetNext();
+    return (next && next->GetParent() == parent) ? next : nullptr;
 }
 
 clRowEntry* clTreeCtrlModel::GetPrevSibling(clRowEntry* item) const
 {
-    if(!item->GetParent()) {
+    clRowEntry* parent = item->GetParent();
+    if(!parent) {
         return nullptr;
     }
-    const clRowEntry::Vec_t& children = item->GetParent()->GetChildren();
-    if(children.empty()) {
-        return nullptr;
+    // The item comes right after the parent or after the last item of the previous sibling's subtree
+    clRowEntry* prev = item->GetPrev();
+    while(prev && prev != parent && prev->GetParent() != parent) {
+        prev = prev->GetParent();
     }
-    size_t where = -1;
-    for(size_t i = 0; i < children.size(); ++i) {
-        if(item == children[i]) {
-            where = i;
-            break;
-        }
-    }
-
-    // if we couldnt find item in the children list or if it's the first child
-    // we return nullptr
-    if((where == (size_t)-1) || (where == (size_t)0)) {
-        return nullptr;
-    }
-
-    --where;
-    return children[where];
+    return (prev == parent) ? nullptr : prev;
 }
 
 void clTreeCtrlModel::AddSelection(const wxTreeItemId& item)
@@ -508,10 +918,8 @@ void clTreeCtrlModel::AddSelection(const wxTreeItemId& item)
         return;
     }
 
-    clRowEntry::Vec_t::iterator iter =
-        std::find_if(m_selectedItems.begin(), m_selectedItems.end(), [&](clRowEntry* p) { return (p == child); });
     // If the item is already selected, don't select it again
-    if(iter != m_selectedItems.end()) {
+    if(child->IsSelected()) {
         return;
     }
 
@@ -524,10 +932,10 @@ void clTreeCtrlModel::AddSelection(const wxTreeItemId& item)
     //        if(!evt.IsAllowed()) { return; }
     //    }
 
-    child->SetSelected(true);
     // Send 'SEL_CHANGED' event
-    m_selectedItems.push_back(child);
-    if(m_selectedItems.size() == 1) {
+    DoAddSelectedItem(child);
+    DoSelectionChanged();
+    if(GetSelectionsCount() == 1) {
         wxTreeEvent evt(wxEVT_TREE_SEL_CHANGED);
         evt.SetEventObject(m_tree);
         evt.SetItem(wxTreeItemId(child));
@@ -537,7 +945,7 @@ void clTreeCtrlModel::AddSelection(const wxTreeItemId& item)
 
 bool clTreeCtrlModel::ClearSelections(bool notify)
 {
-    if(m_selectedItems.empty()) {
+    if(GetSelectionsCount() == 0) {
         return true;
     }
 
@@ -557,15 +965,8 @@ bool clTreeCtrlModel::ClearSelections(bool notify)
 
 bool clTreeCtrlModel::IsItemSelected(const clRowEntry* item) const
 {
-    if(item == nullptr) {
-        return false;
-    }
-    if(m_selectedItems.empty()) {
-        return false;
-    }
-    clRowEntry::Vec_t::const_iterator iter =
-        std::find_if(m_selectedItems.begin(), m_selectedItems.end(), [&](clRowEntry* p) { return (p == item); });
-    return (iter != m_selectedItems.end());
+    // The item flag and the rows ranges are the source of truth, there is no need to search the selected items
+    return item && item->IsSelected();
 }
 
 bool clTreeCtrlModel::IsVisible(const wxTreeItemId& item) const
@@ -573,42 +974,28 @@ bool clTreeCtrlModel::IsVisible(const wxTreeItemId& item) const
     if(!item.IsOk()) {
         return false;
     }
-    clRowEntry* entry = ToPtr(item);
-    clRowEntry::Vec_t::const_iterator iter =
-        std::find_if(m_onScreenItems.begin(), m_onScreenItems.end(), [&](clRowEntry* p) { return (p == entry); });
-    return (iter != m_onScreenItems.end());
+    return IsOnScreen(ToPtr(item));
+}
+
+bool clTreeCtrlModel::IsOnScreen(const clRowEntry* item) const
+{
+    // An item keeps its index after a layout which was not painted, so check that it is still at that position
+    int index = item ? item->GetOnScreenIndex() : wxNOT_FOUND;
+    return (index != wxNOT_FOUND) && ((size_t)index < m_onScreenItems.size()) && (m_onScreenItems[index] == item);
 }
 
 clRowEntry* clTreeCtrlModel::GetRowBefore(clRowEntry* item, bool visibleItem) const
 {
-    clRowEntry* curp = item;
-    if(!curp) {
+    if(!item) {
         return nullptr;
     }
-    curp = curp->GetPrev();
-    while(curp) {
-        if(visibleItem && !curp->IsVisible()) {
-            curp = curp->GetPrev();
-            continue;
-        }
-        break;
-    }
-    return curp;
+    return visibleItem ? item->GetPrevVisible() : item->GetPrev();
 }
 
 clRowEntry* clTreeCtrlModel::GetRowAfter(clRowEntry* item, bool visibleItem) const
 {
-    clRowEntry* curp = item;
-    if(!curp) {
+    if(!item) {
         return nullptr;
     }
-    curp = curp->GetNext();
-    while(curp) {
-        if(visibleItem && !curp->IsVisible()) {
-            curp = curp->GetNext();
-            continue;
-        }
-        break;
-    }
-    return curp;
+    return visibleItem ? item->GetNextVisible() : item->GetNext();
 }
@@ -1,9 +1,13 @@
 #ifndef CLTREECTRLMODEL_H
 #define CLTREECTRLMODEL_H
 
+#include "clMemoryPool.h"
 #include "clRowEntry.h"
+#include "clRowRanges.h"
 #include "codelite_exports.h"
 #include <functional>
+#include <list>
+#include <unordered_map>
 #include <vector>
 #include <wx/colour.h>
 #include <wx/sharedptr.h>
@@ -11,23 +15,86 @@
 #include <wx/treebase.h>
 
 class clTreeCtrl;
+/**
+ * @brief describes an item for the bulk append methods
+ */
+struct WXDLLIMPEXP_SDK clTreeItemInfo {
+    wxString text;
+    int image = wxNOT_FOUND;
+    int selImage = wxNOT_FOUND;
+    wxTreeItemData* data = nullptr;
+
+    clTreeItemInfo() {}
+    clTreeItemInfo(const wxString& text, int image = wxNOT_FOUND, int selImage = wxNOT_FOUND,
+                   wxTreeItemData* data = nullptr)
+        : text(text)
+        , image(image)
+        , selImage(selImage)
+        , data(data)
+    {
+    }
+};
+
 typedef std::function<bool(clRowEntry*, clRowEntry*)> clSortFunc_t;
 class WXDLLIMPEXP_SDK clTreeCtrlModel
 {
     clTreeCtrl* m_tree = nullptr;
     clRowEntry* m_root = nullptr;
-    clRowEntry::Vec_t m_selectedItems;
+    // The items selected on their own (see clRowEntry::SetSelected) in selection order, and their list entries
+    std::list<clRowEntry*> m_selectedItems;
+    std::unordered_map<clRowEntry*, std::list<clRowEntry*>::iterator> m_selectedItemsIndex;
+    clRowRanges m_selectedRanges;              // selected visible rows
     clRowEntry::Vec_t m_onScreenItems;
     clRowEntry* m_firstItemOnScreen = nullptr;
+    clRowEntry* m_hoveredItem = nullptr;
     int m_indentSize = 16;
     bool m_shutdown = false;
     clSortFunc_t m_shouldInsertBeforeFunc = nullptr;
+    clMemoryPool m_pool;
+    bool m_usePool = false;
+    bool m_formatCache = true;
 
 protected:
-    void DoExpandAllChildren(const wxTreeItemId& item, bool expand);
+    bool DoExpandAllChildren(const wxTreeItemId& item, bool expand);
     bool IsSingleSelection() const;
     bool IsMultiSelection() const;
     bool SendEvent(wxEvent& event);
+    void DoDeleteItem(clRowEntry* node);
+
+    /**
+     * @brief the default sort function: by label, case insensitive
+     */
+    static bool DefaultSortFunction(clRowEntry* a, clRowEntry* b);
+    /**
+     * @brief when the default sort function is used, items can be ordered using precomputed keys (see GetSortKey)
+     */
+    bool IsDefaultSortFunction() const;
+    /**
+     * @brief return the position (in the parent's children) where 'child' should be inserted
+     */
+    size_t DoGetInsertPosition(clRowEntry* parent, clRowEntry* child) const;
+    /**
+     * @brief stable sort 'rows' using the sort function. When 'parallel' is true, all the cores are used
+     */
+    void DoSortRows(clRowEntry::Vec_t& rows, bool parallel) const;
+
+    // Selected rows ranges
+    bool DoIsInSelectedRanges(const clRowEntry* item) const;
+    void DoFlushSelectedRanges();
+    void DoUnselectItem(clRowEntry* item);
+    /**
+     * @brief select 'item' on its own. It becomes the last selected item
+     */
+    void DoAddSelectedItem(clRowEntry* item);
+    /**
+     * @brief remove 'item' from the items selected on their own. Return false if it was not one of them
+     */
+    bool DoRemoveSelectedItem(clRowEntry* item);
+    void DoClearSelectedItems();
+    /**
+     * @brief let the tree know that the selection has changed (see clTreeCtrl::EnableBatchEvents)
+     */
+    void DoSelectionChanged();
 
 public:
     clTreeCtrlModel(clTreeCtrl* tree);
@@ -36,14 +103,43 @@ public:
     void SetFirstItemOnScreen(clRowEntry* firstItemOnScreen) { this->m_firstItemOnScreen = firstItemOnScreen; }
     clRowEntry* GetFirstItemOnScreen() const { return m_firstItemOnScreen; }
 
+    /**
+     * @brief the row under the mouse. It is forgotten when it is deleted or no longer on screen
+     */
+    void SetHoveredItem(clRowEntry* item) { m_hoveredItem = item; }
+    clRowEntry* GetHoveredItem() const { return m_hoveredItem; }
+
     void SetSortFunction(const clSortFunc_t& CompareFunc) { m_shouldInsertBeforeFunc = CompareFunc; }
     clSortFunc_t GetSortFunction() const { return m_shouldInsertBeforeFunc; }
 
-    void ExpandAllChildren(const wxTreeItemId& item);
-    void CollapseAllChildren(const wxTreeItemId& item);
+    /**
+     * @brief the key used to sort 'label' (case insensitive). Comparing two keys gives the same result as the default
+     * sort function
+     */
+    static wxString GetSortKey(const wxString& label) { return label.Lower(); }
+    /**
+     * @brief compare a sort key with a label (without computing the label's key)
+     */
+    static int CompareSortKey(const wxString& key, const wxString& label);
+
+    /**
+     * @brief expand (collapse) 'item' and all its descendants. Instead of the item by item events, a single
+     * wxEVT_TREE_EXPANDING_ALL (wxEVT_TREE_COLLAPSING_ALL) event is fired before, which can veto the operation, and a
+     * single wxEVT_TREE_EXPANDED_ALL (wxEVT_TREE_COLLAPSED_ALL) event after. Return false if vetoed.
+     * Note: wxEVT_TREE_ITEM_EXPANDING is no longer fired for the descendants. Code that populates the children lazily
+     * (e.g. replacing a dummy child on expanding) must handle wxEVT_TREE_EXPANDING_ALL and populate the whole subtree
+     */
+    bool ExpandAllChildren(const wxTreeItemId& item);
+    bool CollapseAllChildren(const wxTreeItemId& item);
 
     // Notifications from the node
     void NodeDeleted(clRowEntry* node);
+    /**
+     * @brief remove all the items that are marked for deletion (see clRowEntry::IsDeleting) from the various caches.
+     * The deleted items are linked from 'first' up to 'after' (excluded). Return true if this left the tree without
+     * selection
+     */
+    bool NodesDeleted(clRowEntry* first, clRowEntry* after);
     void NodeExpanded(clRowEntry* node, bool expanded);
     bool NodeExpanding(clRowEntry* node, bool expanding);
 
@@ -54,15 +150,54 @@ public:
                             wxTreeItemData* data);
     wxTreeItemId InsertItem(const wxTreeItemId& parent, const wxTreeItemId& previous, const wxString& text, int image,
                             int selImage, wxTreeItemData* data);
+    /**
+     * @brief append 'items' to 'parent' and return the new rows in 'rows'
+     */
+    void AppendItems(const wxTreeItemId& parent, const std::vector<clTreeItemInfo>& items, clRowEntry::Vec_t& rows);
+    /**
+     * @brief add rows created by the caller (see GetMemoryPool) to 'parent'. The rows are placed like AppendItem would
+     */
+    void AddRows(const wxTreeItemId& parent, const clRowEntry::Vec_t& rows);
+    /**
+     * @brief sort the children of 'item' and of all its descendants using the sort function. With the default sort
+     * function, or when 'threadSafeSortFunction' is set, the sibling groups are sorted concurrently on a pool of worker
+     * threads. Otherwise, the sort function is only called from the calling thread
+     */
+    void SortChildren(const wxTreeItemId& item, bool threadSafeSortFunction = false);
     wxTreeItemId GetRootItem() const;
 
     void SetIndentSize(int indentSize) { this->m_indentSize = indentSize; }
     int GetIndentSize() const { return m_indentSize; }
 
     /**
-     * @brief clear the selection from all the items
+     * @brief clear the selection from all the items. This is O(1) when the items were selected as rows ranges
      */
     void UnselectAll();
+    /**
+     * @brief select all the visible rows, in O(1). Multiple selection trees only
+     */
+    void SelectAll();
+    /**
+     * @brief add the visible rows between 'from' and 'to' (both included) to the selection, in O(log n). Multiple
+     * selection trees only
+     */
+    void SelectRange(clRowEntry* from, clRowEntry* to);
+    /**
+     * @brief is 'item' part of a selected rows range?
+     */
+    bool IsInSelectedRanges(const clRowEntry* item) const
+    {
+        return !m_selectedRanges.IsEmpty() && DoIsInSelectedRanges(item);
+    }
+    /**
+     * @brief the rows are about to be added, removed or moved: convert the selected rows ranges into selected items
+     */
+    void FlushSelectedRanges()
+    {
+        if(!m_selectedRanges.IsEmpty()) {
+            DoFlushSelectedRanges();
+        }
+    }
 
     wxTreeItemId GetItemBefore(const wxTreeItemId& item, bool visibleItem) const;
     wxTreeItemId GetItemAfter(const wxTreeItemId& item, bool visibleItem) const;
@@ -96,6 +231,10 @@ public:
     bool IsItemSelected(const clRowEntry* item) const;
 
     bool IsVisible(const wxTreeItemId& item) const;
+    /**
+     * @brief is 'item' one of the on-screen items? O(1), using the item's on-screen index
+     */
+    bool IsOnScreen(const clRowEntry* item) const;
 
     /**
      * @brief select the children of 'item' this functin fires the changing and changed events
@@ -108,10 +247,17 @@ public:
 
     const clRowEntry::Vec_t& GetOnScreenItems() const { return m_onScreenItems; }
     clRowEntry::Vec_t& GetOnScreenItems() { return m_onScreenItems; }
-    const clRowEntry::Vec_t& GetSelections() const { return m_selectedItems; }
+    /**
+     * @brief return the selected items. The items of the selected rows ranges are collected on demand
+     */
+    void GetSelections(clRowEntry::Vec_t& items) const;
     bool ExpandToItem(const wxTreeItemId& item);
+    /**
+     * @brief return the last item selected on its own or, if the selection is made of rows ranges only, the first
+     * selected row
+     */
     wxTreeItemId GetSingleSelection() const;
-    size_t GetSelectionsCount() const { return m_selectedItems.size(); }
+    size_t GetSelectionsCount() const { return m_selectedItems.size() + m_selectedRanges.GetRowsCount(); }
 
     /**
      * @brief do we have items in this tree? (root included)
@@ -141,6 +287,24 @@ public:
     clRowEntry* GetPrevSibling(clRowEntry* item) const;
 
     void EnableEvents(bool enable) { m_shutdown = !enable; }
+
+    /**
+     * @brief allocate the items and their cells from a memory pool owned by the model. Deleting the root item then
+     * releases all the memory at once. This can only be changed while the model is empty
+     */
+    void EnableMemoryPool(bool enable);
+    /**
+     * @brief return the memory pool used for new items, or nullptr if the items are allocated from the heap
+     */
+    clMemoryPool* GetMemoryPool() { return m_usePool ? &m_pool : nullptr; }
+    const clMemoryPool::Stats& GetMemoryPoolStats() const { return m_pool.GetStats(); }
+
+    /**
+     * @brief numeric and time cells are formatted when drawn. By default the text is kept for the next paint, when
+     * disabled it is released once the row goes off screen
+     */
+    void EnableFormatCache(bool enable) { m_formatCache = enable; }
+    bool IsFormatCacheEnabled() const { return m_formatCache; }
 };
 
 #endif // CLTREECTRLMODEL_H
@@ -0,0 +1,202 @@
+#include "clTreeCtrlVirtualModel.h"
+
+size_t clTreeCtrlVirtualModel::GetIndexInParent(const wxTreeItemId& item) const
+{
+    wxTreeItemId parent = GetParent(item);
+    size_t count = GetChildrenCount(parent);
+    for(size_t i = 0; i < count; ++i) {
+        if(GetChild(parent, i) == item) {
+            return i;
+        }
+    }
+    return count;
+}
+
+clTreeCtrlVirtualRows::clTreeCtrlVirtualRows() {}
+
+clTreeCtrlVirtualRows::~clTreeCtrlVirtualRows() { Reset(nullptr); }
+
+void clTreeCtrlVirtualRows::Reset(clTreeCtrlVirtualModel* model)
+{
+    if(m_root) {
+        DoDelete(m_root);
+        m_root = nullptr;
+    }
+    m_nodes.clear();
+    m_model = model;
+    if(m_model) {
+        // The root is always expanded
+        m_root = new Node();
+        m_root->rows = m_model->GetChildrenCount(wxTreeItemId());
+    }
+}
+
+void clTreeCtrlVirtualRows::Refresh()
+{
+    if(m_root) {
+        DoRefresh(m_root);
+    }
+}
+
+void clTreeCtrlVirtualRows::DoDelete(Node* node)
+{
+    for(const auto& vt : node->expanded) {
+        DoDelete(vt.second);
+    }
+    if(node->item.IsOk()) {
+        m_nodes.erase(node->item.GetID());
+    }
+    delete node;
+}
+
+void clTreeCtrlVirtualRows::DoAddRows(Node* node, long count)
+{
+    for(; node; node = node->parent) {
+        node->rows += count;
+    }
+}
+
+size_t clTreeCtrlVirtualRows::DoRefresh(Node* node)
+{
+    size_t count = m_model->GetChildrenCount(node->item);
+    size_t rows = count;
+    auto iter = node->expanded.begin();
+    while(iter != node->expanded.end()) {
+        Node* child = iter->second;
+        if((iter->first >= count) || (m_model->GetChild(node->item, iter->first) != child->item)) {
+            // The item moved or was removed
+            DoDelete(child);
+            iter = node->expanded.erase(iter);
+            continue;
+        }
+        rows += DoRefresh(child);
+        ++iter;
+    }
+    node->rows = rows;
+    return rows;
+}
+
+clTreeCtrlVirtualRows::Node* clTreeCtrlVirtualRows::DoGetNode(const wxTreeItemId& item) const
+{
+    if(!item.IsOk()) {
+        return m_root;
+    }
+    auto iter = m_nodes.find(item.GetID());
+    return (iter == m_nodes.end()) ? nullptr : iter->second;
+}
+
+wxTreeItemId clTreeCtrlVirtualRows::GetItem(size_t row, int* depth) const
+{
+    if(!m_root || (row >= m_root->rows)) {
+        return wxTreeItemId();
+    }
+
+    const Node* node = m_root;
+    int level = 0;
+    while(true) {
+        // 'row' is relative to the first child of 'node'. Skip the rows of the expanded children that come before it
+        size_t skipped = 0;
+        const Node* next = nullptr;
+        for(const auto& vt : node->expanded) {
+            size_t start = vt.first + skipped;
+            if(row < start) {
+                break;
+            }
+            if(row == start) {
+                if(depth) {
+                    *depth = level;
+                }
+                return vt.second->item;
+            }
+            if(row <= (start + vt.second->rows)) {
+                row -= (start + 1);
+                next = vt.second;
+                break;
+            }
+            skipped += vt.second->rows;
+        }
+
+        if(!next) {
+            if(depth) {
+                *depth = level;
+            }
+            return m_model->GetChild(node->item, row - skipped);
+        }
+        node = next;
+        ++level;
+    }
+}
+
+int clTreeCtrlVirtualRows::GetRow(const wxTreeItemId& item) const
+{
+    if(!m_root || !item.IsOk()) {
+        return wxNOT_FOUND;
+    }
+    const Node* parent = DoGetNode(m_model->GetParent(item));
+    if(!parent) {
+        // collapsed parent
+        return wxNOT_FOUND;
+    }
+
+    const Node* node = DoGetNode(item);
+    size_t index = node ? node->indexInParent : m_model->GetIndexInParent(item);
+    size_t row = 0;
+    // Sum the position of the item in its parent, then the position of the parent in its own parent and so on
+    while(true) {
+        row += index;
+        for(const auto& vt : parent->expanded) {
+            if(vt.first >= index) {
+                break;
+            }
+            row += vt.second->rows;
+        }
+        if(parent == m_root) {
+            break;
+        }
+        // count the parent row itself
+        ++row;
+        index = parent->indexInParent;
+        parent = parent->parent;
+    }
+    return row;
+}
+
+bool clTreeCtrlVirtualRows::Expand(const wxTreeItemId& item)
+{
+    if(!m_root || !item.IsOk()) {
+        return false;
+    }
+    if(DoGetNode(item)) {
+        return true;
+    }
+    Node* parent = DoGetNode(m_model->GetParent(item));
+    if(!parent) {
+        return false;
+    }
+
+    size_t index = m_model->GetIndexInParent(item);
+    if(index >= m_model->GetChildrenCount(parent->item)) {
+        return false;
+    }
+
+    Node* node = new Node();
+    node->item = item;
+    node->parent = parent;
+    node->indexInParent = index;
+    parent->expanded.insert({ node->indexInParent, node });
+    m_nodes.insert({ item.GetID(), node });
+    DoAddRows(node, m_model->GetChildrenCount(item));
+    return true;
+}
+
+bool clTreeCtrlVirtualRows::Collapse(const wxTreeItemId& item)
+{
+    Node* node = item.IsOk() ? DoGetNode(item) : nullptr;
+    if(!node) {
+        return false;
+    }
+    DoAddRows(node->parent, -(long)node->rows);
+    node->parent->expanded.erase(node->indexInParent);
+    DoDelete(node);
+    return true;
+}
@@ -0,0 +1,114 @@
+#ifndef CLTREECTRLVIRTUALMODEL_H
+#define CLTREECTRLVIRTUALMODEL_H
+
+#include "clCellValue.h"
+#include "codelite_exports.h"
+#include <map>
+#include <unordered_map>
+#include <wx/treebase.h>
+
+/**
+ * @brief items provider for clTreeCtrl in virtual mode. Items are identified by ids of the model's choice, the
+ * control never stores them. An invalid id stands for the (hidden) root
+ */
+class WXDLLIMPEXP_SDK clTreeCtrlVirtualModel
+{
+public:
+    clTreeCtrlVirtualModel() {}
+    virtual ~clTreeCtrlVirtualModel() {}
+
+    /**
+     * @brief return the number of children of 'parent'
+     */
+    virtual size_t GetChildrenCount(const wxTreeItemId& parent) const = 0;
+    /**
+     * @brief return the id of the child of 'parent' at 'index'. The id must remain the same for as long as the item
+     * exists
+     */
+    virtual wxTreeItemId GetChild(const wxTreeItemId& parent, size_t index) const = 0;
+    /**
+     * @brief return the parent of 'item'. Top level items return an invalid id
+     */
+    virtual wxTreeItemId GetParent(const wxTreeItemId& item) const = 0;
+    /**
+     * @brief fill 'cell' (text, bitmap, colours, font) for a given item/column. 'cell' is passed as an empty text cell
+     */
+    virtual void GetCellValue(const wxTreeItemId& item, size_t col, clCellValue& cell) const = 0;
+    /**
+     * @brief can 'item' be expanded? Override this if counting the children is expensive
+     */
+    virtual bool HasChildren(const wxTreeItemId& item) const { return GetChildrenCount(item) > 0; }
+    /**
+     * @brief return the position of 'item' among its siblings. The default implementation scans the siblings
+     */
+    virtual size_t GetIndexInParent(const wxTreeItemId& item) const;
+};
+
+/**
+ * @brief maps the visible rows of a virtual tree to the model items. Only the expanded items are kept, so the memory
+ * used depends on the number of expanded items and not on the number of items
+ */
+class WXDLLIMPEXP_SDK clTreeCtrlVirtualRows
+{
+    struct Node {
+        wxTreeItemId item;
+        Node* parent = nullptr;
+        size_t indexInParent = 0;
+        size_t rows = 0;                    // number of visible rows below this item
+        std::map<size_t, Node*> expanded;   // the expanded children, by their index
+    };
+
+    clTreeCtrlVirtualModel* m_model = nullptr;
+    Node* m_root = nullptr;
+    std::unordered_map<void*, Node*> m_nodes; // the expanded items
+
+protected:
+    void DoDelete(Node* node);
+    void DoAddRows(Node* node, long count);
+    size_t DoRefresh(Node* node);
+    Node* DoGetNode(const wxTreeItemId& item) const;
+
+public:
+    clTreeCtrlVirtualRows();
+    ~clTreeCtrlVirtualRows();
+
+    /**
+     * @brief start over with 'model', all the items are collapsed
+     */
+    void Reset(clTreeCtrlVirtualModel* model);
+
+    /**
+     * @brief re-read the children count of the expanded items. Expanded items that are no longer found at their
+     * position are collapsed
+     */
+    void Refresh();
+
+    /**
+     * @brief number of visible rows
+     */
+    size_t GetRowsCount() const { return m_root ? m_root->rows : 0; }
+
+    /**
+     * @brief return the item displayed at 'row' and its depth (0 for top level items)
+     */
+    wxTreeItemId GetItem(size_t row, int* depth = nullptr) const;
+
+    /**
+     * @brief return the row of 'item' or wxNOT_FOUND if one of its parents is collapsed
+     */
+    int GetRow(const wxTreeItemId& item) const;
+
+    bool IsExpanded(const wxTreeItemId& item) const { return DoGetNode(item) != nullptr; }
+
+    /**
+     * @brief expand 'item'. Its parent must be expanded
+     */
+    bool Expand(const wxTreeItemId& item);
+
+    /**
+     * @brief collapse 'item', the state of its children is discarded
+     */
+    bool Collapse(const wxTreeItemId& item);
+};
+
+#endif // CLTREECTRLVIRTUALMODEL_H
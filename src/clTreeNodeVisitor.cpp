@@ -14,6 +14,7 @@ void clTreeNodeVisitor::Visit(clRowEntry* item, bool expandedItemsOnly, std::fun
         } else if(!expandedItemsOnly) {
             if(!func(current, isVisible)) { return; }
         }
-        current = current->GetNext();
+        // When visiting visible items only, collapsed subtrees are skipped in one step
+        current = expandedItemsOnly ? current->GetNextVisible() : current->GetNext();
     }
 }
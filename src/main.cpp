@@ -1,18 +1,29 @@
+#include "Benchmarks.h"
 #include "MainFrame.h"
 #include "clAsciiEscapCodeHandler.hpp"
 #include <wx/app.h>
 #include <wx/event.h>
+#include <wx/frame.h>
 #include <wx/image.h>
 
 // Define the MainApp
 class MainApp : public wxApp
 {
+    bool m_runBenchmarks = false;
+
 public:
     MainApp() {}
     virtual ~MainApp() {}
 
     virtual bool OnInit()
     {
+        // Opt-in: print the benchmarks results and exit, without showing the demo
+        for(int i = 1; i < argc; ++i) {
+            if(wxString(argv[i]) == "--benchmark") {
+                m_runBenchmarks = true;
+                return true;
+            }
+        }
 #ifdef __WXMSW__
         MSWEnableDarkMode(wxApp::DarkMode_Always);
         typedef BOOL WINAPI (*SetProcessDPIAwareFunc)();
@@ -33,6 +44,17 @@ public:
         SetTopWindow(mainFrame);
         return GetTopWindow()->Show();
     }
+
+    virtual int OnRun()
+    {
+        if(!m_runBenchmarks) {
+            return wxApp::OnRun();
+        }
+        wxFrame* frame = new wxFrame(NULL, wxID_ANY, "Benchmarks");
+        RunBenchmarks(frame);
+        frame->Destroy();
+        return 0;
+    }
 };
 
 DECLARE_APP(MainApp)